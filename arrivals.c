@@ -0,0 +1,26 @@
+#include "arrivals.h"
+#include <math.h>
+
+void init_arrival_rate(ArrivalRate *estimate, double now)
+{
+    estimate->rate = 0.0f;
+    estimate->last_update = now;
+}
+
+// Decays the estimate to `now`, then adds n arrivals, each an impulse of
+// weight 1/window. For Poisson arrivals the result is an unbiased estimate
+// of the rate over roughly the last window seconds.
+void record_arrivals(ArrivalRate *estimate, int n, double now)
+{
+    estimate->rate = arrival_rate(estimate, now) + n * (1.0f / ARRIVAL_RATE_WINDOW);
+    if (now > estimate->last_update)
+        estimate->last_update = now;
+}
+
+float arrival_rate(const ArrivalRate *estimate, double now)
+{
+    float elapsed = (float)(now - estimate->last_update); // Small, so float is exact enough
+    if (elapsed <= 0.0f)
+        return estimate->rate;
+    return estimate->rate * expf(-elapsed * (1.0f / ARRIVAL_RATE_WINDOW));
+}
@@ -0,0 +1,19 @@
+#ifndef ARRIVALS_H
+#define ARRIVALS_H
+
+#define ARRIVAL_RATE_WINDOW 30.0f // Time constant of the moving average (s)
+
+// Streaming estimate of one lane's arrival rate: an exponentially weighted
+// moving average of arrival events in continuous time, so it needs no
+// history and stays correct however irregularly it is updated or read.
+typedef struct
+{
+    float rate;        // Arrivals per second as of last_update
+    double last_update; // Seconds, same clock as the callers' `now`
+} ArrivalRate;
+
+void init_arrival_rate(ArrivalRate *estimate, double now);
+void record_arrivals(ArrivalRate *estimate, int n, double now);
+float arrival_rate(const ArrivalRate *estimate, double now);
+
+#endif
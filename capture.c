@@ -0,0 +1,500 @@
+#include "capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define FRAMES_PER_WORKER 2 // In-flight buffers per worker; bounds memory use
+#define PNG_STORED_BLOCK 65535
+
+typedef enum
+{
+    CAPTURE_Y4M,
+    CAPTURE_PNG,
+    CAPTURE_RAW
+} CaptureFormat;
+
+typedef struct
+{
+    uint8_t *pixels;  // RGBA filled by the render thread
+    uint8_t *encoded; // Worker scratch: I420 planes or a whole PNG file
+    long sequence;
+} CaptureFrame;
+
+struct Capture
+{
+    CaptureFormat format;
+    char path[256];
+    FILE *out; // Single stream for Y4M and raw output
+    int width;
+    int height;
+    size_t frameBytes;
+    size_t encodedBytes;
+
+    CaptureFrame *frames;
+    int numFrames;
+    int *freeFrames; // Stack of buffers the render thread may fill
+    int numFree;
+    int *pending; // FIFO of submitted buffers, in sequence order
+    int pendingHead;
+    int numPending;
+
+    long nextSequence;
+    long nextWrite; // Streamed formats must be written in sequence order
+    long written;
+    bool failed;
+    bool closing;
+
+    pthread_mutex_t lock;
+    pthread_cond_t frameFreed;
+    pthread_cond_t workReady;
+    pthread_cond_t writeTurn;
+    pthread_t *workers;
+    int numWorkers;
+};
+
+static uint32_t crcTable[256];
+static pthread_once_t crcOnce = PTHREAD_ONCE_INIT;
+
+static void initCrcTable(void)
+{
+    for (uint32_t n = 0; n < 256; n++)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crcTable[n] = c;
+    }
+}
+
+static uint32_t crc32(const uint8_t *data, size_t length)
+{
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++)
+        c = crcTable[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+static uint8_t *putBE32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+    return p + 4;
+}
+
+static size_t pngRawBytes(int width, int height)
+{
+    return (size_t)height * (1 + (size_t)width * 4); // Filter byte per row
+}
+
+static size_t pngFileBytes(int width, int height)
+{
+    size_t raw = pngRawBytes(width, height);
+    size_t blocks = (raw + PNG_STORED_BLOCK - 1) / PNG_STORED_BLOCK;
+    size_t zlib = 2 + raw + 5 * blocks + 4;
+    return 8 + (12 + 13) + (12 + zlib) + 12;
+}
+
+// Minimal PNG writer: RGBA8, no filtering, zlib "stored" blocks. Files are
+// large but encoding is a memcpy, which keeps workers ahead of long runs.
+static size_t encodePng(const uint8_t *rgba, int width, int height, uint8_t *out)
+{
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t *p = out;
+
+    memcpy(p, signature, 8);
+    p += 8;
+
+    uint8_t *chunk = p;
+    p = putBE32(p, 13);
+    memcpy(p, "IHDR", 4);
+    p += 4;
+    p = putBE32(p, width);
+    p = putBE32(p, height);
+    *p++ = 8; // Bit depth
+    *p++ = 6; // RGBA
+    *p++ = 0;
+    *p++ = 0;
+    *p++ = 0;
+    p = putBE32(p, crc32(chunk + 4, 17));
+
+    size_t raw = pngRawBytes(width, height);
+    size_t blocks = (raw + PNG_STORED_BLOCK - 1) / PNG_STORED_BLOCK;
+    size_t zlibBytes = 2 + raw + 5 * blocks + 4;
+
+    chunk = p;
+    p = putBE32(p, (uint32_t)zlibBytes);
+    memcpy(p, "IDAT", 4);
+    p += 4;
+    *p++ = 0x78; // zlib header, no compression
+    *p++ = 0x01;
+
+    uint32_t adlerA = 1, adlerB = 0;
+    size_t remaining = raw, blockLeft = 0;
+    size_t rowBytes = (size_t)width * 4;
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t *row = rgba + y * rowBytes;
+        for (size_t i = 0; i <= rowBytes; i++)
+        {
+            if (blockLeft == 0)
+            {
+                blockLeft = remaining < PNG_STORED_BLOCK ? remaining : PNG_STORED_BLOCK;
+                *p++ = (remaining == blockLeft) ? 1 : 0; // BFINAL on the last block
+                *p++ = blockLeft & 0xFF;
+                *p++ = blockLeft >> 8;
+                *p++ = ~blockLeft & 0xFF;
+                *p++ = (~blockLeft >> 8) & 0xFF;
+            }
+
+            // Copy as much of the row as fits in the current block
+            size_t n = (i == 0) ? 1 : rowBytes - i + 1;
+            if (n > blockLeft)
+                n = blockLeft;
+            if (i == 0)
+                *p = 0; // Filter type None
+            else
+                memcpy(p, row + i - 1, n);
+
+            for (size_t k = 0; k < n; k++)
+            {
+                adlerA = (adlerA + p[k]) % 65521;
+                adlerB = (adlerB + adlerA) % 65521;
+            }
+            p += n;
+            i += n - 1;
+            blockLeft -= n;
+            remaining -= n;
+        }
+    }
+    p = putBE32(p, (adlerB << 16) | adlerA);
+    p = putBE32(p, crc32(chunk + 4, 4 + zlibBytes));
+
+    p = putBE32(p, 0);
+    memcpy(p, "IEND", 4);
+    p += 4;
+    p = putBE32(p, crc32(p - 4, 4));
+    return p - out;
+}
+
+// BT.601 full-range RGB to planar 4:2:0, matching the Y4M "C420jpeg" tag
+static size_t encodeI420(const uint8_t *rgba, int width, int height, uint8_t *out)
+{
+    int chromaW = (width + 1) / 2, chromaH = (height + 1) / 2;
+    uint8_t *yPlane = out;
+    uint8_t *uPlane = yPlane + (size_t)width * height;
+    uint8_t *vPlane = uPlane + (size_t)chromaW * chromaH;
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t *px = rgba + (size_t)y * width * 4;
+        for (int x = 0; x < width; x++, px += 4)
+            yPlane[(size_t)y * width + x] = (77 * px[0] + 150 * px[1] + 29 * px[2] + 128) >> 8;
+    }
+
+    for (int cy = 0; cy < chromaH; cy++)
+    {
+        for (int cx = 0; cx < chromaW; cx++)
+        {
+            int r = 0, g = 0, b = 0;
+            for (int dy = 0; dy < 2; dy++)
+            {
+                for (int dx = 0; dx < 2; dx++)
+                {
+                    int sx = cx * 2 + dx < width ? cx * 2 + dx : width - 1;
+                    int sy = cy * 2 + dy < height ? cy * 2 + dy : height - 1;
+                    const uint8_t *px = rgba + ((size_t)sy * width + sx) * 4;
+                    r += px[0];
+                    g += px[1];
+                    b += px[2];
+                }
+            }
+            r /= 4;
+            g /= 4;
+            b /= 4;
+            uPlane[(size_t)cy * chromaW + cx] = (-43 * r - 85 * g + 128 * b + 32896) >> 8;
+            vPlane[(size_t)cy * chromaW + cx] = (128 * r - 107 * g - 21 * b + 32896) >> 8;
+        }
+    }
+    return (size_t)width * height + 2 * (size_t)chromaW * chromaH;
+}
+
+// Waits for this frame's turn on the shared stream, writes it, and passes the turn on
+static bool writeInOrder(Capture *capture, CaptureFrame *frame, const uint8_t *data, size_t size)
+{
+    pthread_mutex_lock(&capture->lock);
+    while (capture->nextWrite != frame->sequence)
+        pthread_cond_wait(&capture->writeTurn, &capture->lock);
+    pthread_mutex_unlock(&capture->lock);
+
+    bool ok = true;
+    if (capture->format == CAPTURE_Y4M)
+        ok = fputs("FRAME\n", capture->out) >= 0;
+    ok = ok && fwrite(data, 1, size, capture->out) == size;
+
+    pthread_mutex_lock(&capture->lock);
+    capture->nextWrite++;
+    pthread_cond_broadcast(&capture->writeTurn);
+    pthread_mutex_unlock(&capture->lock);
+    return ok;
+}
+
+static bool writeFrame(Capture *capture, CaptureFrame *frame)
+{
+    switch (capture->format)
+    {
+    case CAPTURE_Y4M:
+    {
+        size_t size = encodeI420(frame->pixels, capture->width, capture->height, frame->encoded);
+        return writeInOrder(capture, frame, frame->encoded, size);
+    }
+    case CAPTURE_RAW:
+        return writeInOrder(capture, frame, frame->pixels, capture->frameBytes);
+    case CAPTURE_PNG:
+    default:
+    {
+        char filename[512];
+        size_t size = encodePng(frame->pixels, capture->width, capture->height, frame->encoded);
+        snprintf(filename, sizeof(filename), capture->path, (int)frame->sequence);
+        FILE *file = fopen(filename, "wb");
+        if (!file)
+            return false;
+        bool ok = fwrite(frame->encoded, 1, size, file) == size;
+        return (fclose(file) == 0) && ok;
+    }
+    }
+}
+
+static void *captureWorker(void *arg)
+{
+    Capture *capture = (Capture *)arg;
+
+    pthread_mutex_lock(&capture->lock);
+    while (1)
+    {
+        while (capture->numPending == 0 && !capture->closing)
+            pthread_cond_wait(&capture->workReady, &capture->lock);
+        if (capture->numPending == 0)
+            break; // Closing and fully drained
+
+        int index = capture->pending[capture->pendingHead];
+        capture->pendingHead = (capture->pendingHead + 1) % capture->numFrames;
+        capture->numPending--;
+        pthread_mutex_unlock(&capture->lock);
+
+        bool ok = writeFrame(capture, &capture->frames[index]);
+
+        pthread_mutex_lock(&capture->lock);
+        if (ok)
+        {
+            capture->written++;
+        }
+        else if (!capture->failed)
+        {
+            fprintf(stderr, "Failed to write frame %ld of %s\n", capture->frames[index].sequence, capture->path);
+            capture->failed = true;
+        }
+        capture->freeFrames[capture->numFree++] = index;
+        pthread_cond_signal(&capture->frameFreed);
+    }
+    pthread_mutex_unlock(&capture->lock);
+    return NULL;
+}
+
+static void freeCapture(Capture *capture)
+{
+    if (capture->frames)
+    {
+        for (int i = 0; i < capture->numFrames; i++)
+        {
+            free(capture->frames[i].pixels);
+            free(capture->frames[i].encoded);
+        }
+    }
+    if (capture->out)
+        fclose(capture->out);
+    free(capture->frames);
+    free(capture->freeFrames);
+    free(capture->pending);
+    free(capture->workers);
+    free(capture);
+}
+
+// The PNG path is used as a printf format for the frame number, so it must
+// hold exactly one %d conversion (optionally zero-padded, e.g. %06d) and no
+// other conversions than %%
+static bool isFramePattern(const char *path)
+{
+    int conversions = 0;
+    for (const char *p = strchr(path, '%'); p; p = strchr(p, '%'))
+    {
+        p++;
+        if (*p == '%')
+        {
+            p++;
+            continue;
+        }
+        while (*p >= '0' && *p <= '9')
+            p++;
+        if (*p != 'd')
+            return false;
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+Capture *capture_open(const char *path, int width, int height, int fps, int workers)
+{
+    if (workers < 1)
+        workers = 1;
+
+    Capture *capture = calloc(1, sizeof(Capture));
+    if (!capture)
+        return NULL;
+
+    size_t len = strlen(path);
+    if (len >= sizeof(capture->path))
+    {
+        fprintf(stderr, "Capture path too long: %s\n", path);
+        free(capture);
+        return NULL;
+    }
+    memcpy(capture->path, path, len + 1);
+    capture->width = width;
+    capture->height = height;
+    capture->frameBytes = (size_t)width * height * 4;
+
+    if (len > 4 && strcmp(path + len - 4, ".y4m") == 0)
+    {
+        capture->format = CAPTURE_Y4M;
+        capture->encodedBytes = (size_t)width * height + 2 * (size_t)((width + 1) / 2) * ((height + 1) / 2);
+    }
+    else if (strchr(path, '%'))
+    {
+        if (!isFramePattern(path))
+        {
+            fprintf(stderr, "PNG capture path needs exactly one %%d frame number (e.g. %%06d): %s\n", path);
+            free(capture);
+            return NULL;
+        }
+        capture->format = CAPTURE_PNG;
+        capture->encodedBytes = pngFileBytes(width, height);
+        pthread_once(&crcOnce, initCrcTable);
+    }
+    else
+    {
+        capture->format = CAPTURE_RAW;
+    }
+
+    if (capture->format != CAPTURE_PNG)
+    {
+        capture->out = fopen(path, "wb");
+        if (!capture->out)
+        {
+            perror(path);
+            freeCapture(capture);
+            return NULL;
+        }
+        if (capture->format == CAPTURE_Y4M)
+            fprintf(capture->out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+    }
+
+    capture->numFrames = workers * FRAMES_PER_WORKER + 1; // +1 so the renderer rarely waits
+    capture->frames = calloc(capture->numFrames, sizeof(CaptureFrame));
+    capture->freeFrames = malloc(sizeof(int) * capture->numFrames);
+    capture->pending = malloc(sizeof(int) * capture->numFrames);
+    capture->workers = malloc(sizeof(pthread_t) * workers);
+    if (!capture->frames || !capture->freeFrames || !capture->pending || !capture->workers)
+    {
+        freeCapture(capture);
+        return NULL;
+    }
+
+    for (int i = 0; i < capture->numFrames; i++)
+    {
+        capture->frames[i].pixels = malloc(capture->frameBytes);
+        capture->frames[i].encoded = capture->encodedBytes ? malloc(capture->encodedBytes) : NULL;
+        if (!capture->frames[i].pixels || (capture->encodedBytes && !capture->frames[i].encoded))
+        {
+            fprintf(stderr, "Out of memory for capture buffers\n");
+            freeCapture(capture);
+            return NULL;
+        }
+        capture->freeFrames[capture->numFree++] = i;
+    }
+
+    pthread_mutex_init(&capture->lock, NULL);
+    pthread_cond_init(&capture->frameFreed, NULL);
+    pthread_cond_init(&capture->workReady, NULL);
+    pthread_cond_init(&capture->writeTurn, NULL);
+    for (int i = 0; i < workers; i++)
+    {
+        if (pthread_create(&capture->workers[i], NULL, captureWorker, capture) != 0)
+            break;
+        capture->numWorkers++;
+    }
+    if (capture->numWorkers == 0)
+    {
+        fprintf(stderr, "Failed to start capture workers\n");
+        freeCapture(capture);
+        return NULL;
+    }
+    return capture;
+}
+
+// Returns an RGBA buffer of width*height*4 bytes. Blocks only while every
+// buffer in the pool is still queued or being encoded.
+uint8_t *capture_acquire(Capture *capture)
+{
+    pthread_mutex_lock(&capture->lock);
+    while (capture->numFree == 0)
+        pthread_cond_wait(&capture->frameFreed, &capture->lock);
+    int index = capture->freeFrames[--capture->numFree];
+    pthread_mutex_unlock(&capture->lock);
+    return capture->frames[index].pixels;
+}
+
+// Hands a filled buffer from capture_acquire to the workers
+void capture_submit(Capture *capture, uint8_t *pixels)
+{
+    int index = 0;
+    while (index < capture->numFrames && capture->frames[index].pixels != pixels)
+        index++;
+    if (index == capture->numFrames)
+        return;
+
+    pthread_mutex_lock(&capture->lock);
+    capture->frames[index].sequence = capture->nextSequence++;
+    capture->pending[(capture->pendingHead + capture->numPending) % capture->numFrames] = index;
+    capture->numPending++;
+    pthread_cond_signal(&capture->workReady);
+    pthread_mutex_unlock(&capture->lock);
+}
+
+// Drains queued frames, stops the workers and returns the number of frames
+// written, or -1 if any frame failed to write
+long capture_close(Capture *capture)
+{
+    pthread_mutex_lock(&capture->lock);
+    capture->closing = true;
+    pthread_cond_broadcast(&capture->workReady);
+    pthread_mutex_unlock(&capture->lock);
+
+    for (int i = 0; i < capture->numWorkers; i++)
+        pthread_join(capture->workers[i], NULL);
+
+    long written = capture->failed ? -1 : capture->written;
+    if (capture->out && fclose(capture->out) != 0)
+        written = -1;
+    capture->out = NULL;
+
+    pthread_mutex_destroy(&capture->lock);
+    pthread_cond_destroy(&capture->frameFreed);
+    pthread_cond_destroy(&capture->workReady);
+    pthread_cond_destroy(&capture->writeTurn);
+    freeCapture(capture);
+    return written;
+}
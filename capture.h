@@ -0,0 +1,19 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+
+// Asynchronous frame export. The render thread fills RGBA buffers from a
+// fixed pool; worker threads convert and write them so encoding never runs
+// on the render thread. The output format follows the path:
+//   *.y4m          - YUV4MPEG2 4:2:0 video (playable by ffmpeg/mpv)
+//   pattern with % - PNG image sequence, e.g. "frames/%06d.png"
+//   anything else  - headerless raw RGBA frames
+typedef struct Capture Capture;
+
+Capture *capture_open(const char *path, int width, int height, int fps, int workers);
+uint8_t *capture_acquire(Capture *capture);
+void capture_submit(Capture *capture, uint8_t *pixels);
+long capture_close(Capture *capture);
+
+#endif
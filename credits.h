@@ -0,0 +1,44 @@
+#ifndef CREDITS_H
+#define CREDITS_H
+
+#include <stdio.h>
+#include "scheduler.h"
+
+// Flow control between producers (traffic_gen) and the simulator.
+//
+// The simulator reads one input file per shard: shard 0 is vehicles.data,
+// shard k > 0 is vehicles.data.k. Records are
+// "ID:Road:Lane[:Timestamp][:Class]", where Timestamp is the producer's wall
+// clock in milliseconds; records without one are stamped when parsed. Class
+// is one letter of VEHICLE_CLASS_CODES (N normal, B bus, E emergency) and
+// defaults to N. Lanes are fed from all shards in timestamp order.
+//
+// After every read of a shard the simulator replaces its credits file
+// (credits.data, or credits.data.k) atomically via a temp file and rename:
+//
+//   CREDITS <session> <accepted x NUM_LANES> <free x NUM_LANES>
+//
+// `accepted` is the cumulative number of vehicles taken from that shard for
+// each lane since `session` started. `free` is the shard's share of each
+// lane's remaining queue space. A producer that has sent `sent` vehicles to
+// a lane may send `free - (sent - accepted)` more. A new session means the
+// simulator restarted and every count is reset.
+//
+// Writers must hold an exclusive flock() on the shard file while appending,
+// so the simulator never truncates a line it has not read.
+#define VEHICLE_BASE_FILE "vehicles.data"
+#define CREDITS_BASE_FILE "credits.data"
+#define CREDITS_TAG "CREDITS"
+#define MAX_SHARDS 32
+#define VEHICLE_CLASS_CODES "NBE" // Indexed by VehicleClass
+
+// Builds the per-shard name of a base file ("vehicles.data" -> "vehicles.data.3")
+static inline void shard_file_name(char *out, size_t size, const char *base, int shard)
+{
+    if (shard == 0)
+        snprintf(out, size, "%s", base);
+    else
+        snprintf(out, size, "%s.%d", base, shard);
+}
+
+#endif
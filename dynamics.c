@@ -0,0 +1,184 @@
+#include "dynamics.h"
+#include <math.h>
+#include <string.h>
+
+#define DYN_FREE_GAP 1.0e4f // Stand-in gap when nothing is ahead
+#define DYN_MIN_SPACING 0.1f
+
+// Plain ternaries (rather than fmaxf) let GCC emit packed max instructions
+static inline float max_f(float a, float b)
+{
+    return a > b ? a : b;
+}
+
+static inline float min_f(float a, float b)
+{
+    return a < b ? a : b;
+}
+
+// IDM acceleration for a vehicle at speed v with the given bumper gap and
+// approach rate dv (own speed minus leader speed)
+static inline float idm_accel(float v, float gap, float dv)
+{
+    const float interaction = 0.5f / sqrtf(DYN_MAX_ACCEL * DYN_COMFORT_DECEL);
+    float sStar = DYN_MIN_GAP + max_f(0.0f, v * DYN_TIME_HEADWAY + v * dv * interaction);
+    float q = sStar / max_f(gap, DYN_MIN_SPACING);
+    float r = v * (1.0f / DYN_DESIRED_SPEED);
+    float r2 = r * r;
+    return DYN_MAX_ACCEL * (1.0f - r2 * r2 - q * q);
+}
+
+// A red light is a standing obstacle at the stop line, but only for vehicles
+// that have not crossed it and can still stop in time
+static inline float stop_line_accel(float pos, float v, float red)
+{
+    float stoppingDistance = v * v * (0.5f / DYN_MAX_DECEL);
+    int blocked = (red > 0.0f) & (pos < -stoppingDistance); // Non-short-circuit keeps the loop branch-free
+    float gap = blocked ? -pos : DYN_FREE_GAP;
+    return idm_accel(v, gap, v);
+}
+
+static int count_moving(const LaneDynamics *lane)
+{
+    int moving = 0;
+    for (int i = 0; i < lane->count; i++)
+        moving += lane->vel[i] > 0.0f;
+    return moving;
+}
+
+void init_lane_dynamics(LaneDynamics *lane)
+{
+    lane->count = 0;
+    lane->moving = 0;
+}
+
+// Places a newly enqueued vehicle at rest behind the last one (or at the stop line)
+void add_vehicle_dynamics(LaneDynamics *lane)
+{
+    if (lane->count == MAX_QUEUE_SIZE)
+        return;
+
+    float pos = -DYN_MIN_GAP;
+    if (lane->count > 0)
+        pos = min_f(pos, lane->pos[lane->count - 1] - DYN_VEHICLE_LENGTH - DYN_MIN_GAP);
+
+    lane->pos[lane->count] = pos;
+    lane->vel[lane->count] = 0.0f;
+    lane->acc[lane->count] = 0.0f;
+    lane->count++;
+}
+
+// Places a vehicle that overtook waiting traffic at `index` (0 = front). It
+// takes the displaced vehicle's spot and speed; the vehicles behind it drop
+// back as far as needed to keep the standstill gap.
+void insert_vehicle_dynamics(LaneDynamics *lane, int index)
+{
+    if (lane->count == MAX_QUEUE_SIZE)
+        return;
+    if (index >= lane->count)
+    {
+        add_vehicle_dynamics(lane);
+        return;
+    }
+
+    int tail = lane->count - index;
+    memmove(lane->pos + index + 1, lane->pos + index, tail * sizeof(float));
+    memmove(lane->vel + index + 1, lane->vel + index, tail * sizeof(float));
+    memmove(lane->acc + index + 1, lane->acc + index, tail * sizeof(float));
+    lane->acc[index] = 0.0f;
+    lane->count++;
+    lane->moving += lane->vel[index] > 0.0f;
+
+    for (int i = index + 1; i < lane->count; i++)
+        lane->pos[i] = min_f(lane->pos[i], lane->pos[i - 1] - DYN_VEHICLE_LENGTH - DYN_MIN_GAP);
+}
+
+// Vehicles at the front that are past the stop line or too close to stop
+// before it; nothing may be queued ahead of them
+int committed_vehicles(const LaneDynamics *lane)
+{
+    int n = 0;
+    while (n < lane->count && lane->pos[n] >= -lane->vel[n] * lane->vel[n] * (0.5f / DYN_MAX_DECEL))
+        n++;
+    return n;
+}
+
+// Advances every vehicle in the lane by dt. Returns how many vehicles at the
+// front have driven clear of the junction; the caller removes them.
+int step_lane_dynamics(LaneDynamics *lane, bool green, float dt)
+{
+    int n = lane->count;
+    if (n == 0)
+        return 0;
+    int moving = 0;
+
+    float *restrict pos = lane->pos;
+    float *restrict vel = lane->vel;
+    float *restrict acc = lane->acc;
+    const float red = green ? 0.0f : 1.0f;
+
+    // The front vehicle only sees the stop line
+    acc[0] = min_f(idm_accel(vel[0], DYN_FREE_GAP, 0.0f), stop_line_accel(pos[0], vel[0], red));
+
+    for (int i = 1; i < n; i++)
+    {
+        float v = vel[i];
+        float gap = pos[i - 1] - pos[i] - DYN_VEHICLE_LENGTH;
+        float follow = idm_accel(v, gap, v - vel[i - 1]);
+        acc[i] = min_f(follow, stop_line_accel(pos[i], v, red));
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        float a = max_f(acc[i], -DYN_MAX_DECEL);
+        float v = vel[i];
+        float vNext = max_f(v + a * dt, 0.0f);
+        // The IDM only approaches rest asymptotically; without this a stopped
+        // queue keeps a residual crawl and never reads as stopped
+        vNext = (vNext < DYN_STOP_SPEED && a < DYN_STOP_ACCEL) ? 0.0f : vNext;
+        pos[i] += 0.5f * (v + vNext) * dt;
+        vel[i] = vNext;
+        moving += vNext > 0.0f;
+    }
+    lane->moving = moving;
+
+    int cleared = 0;
+    while (cleared < n && pos[cleared] > DYN_CLEAR_DISTANCE)
+        cleared++;
+    return cleared;
+}
+
+void remove_front_vehicles(LaneDynamics *lane, int n)
+{
+    if (n <= 0)
+        return;
+    if (n > lane->count)
+        n = lane->count;
+
+    int remaining = lane->count - n;
+    memmove(lane->pos, lane->pos + n, remaining * sizeof(float));
+    memmove(lane->vel, lane->vel + n, remaining * sizeof(float));
+    memmove(lane->acc, lane->acc + n, remaining * sizeof(float));
+    lane->count = remaining;
+    lane->moving = count_moving(lane);
+}
+
+bool lane_is_moving(const LaneDynamics *lane)
+{
+    return lane->moving > 0;
+}
+
+// Steps a lane and dequeues the vehicles that cleared the junction, copying up
+// to maxCleared of them into cleared. Returns the number dequeued.
+int advance_lane(LaneDynamics *lane, Queue *queue, bool green, float dt, Vehicle *cleared, int maxCleared)
+{
+    int n = step_lane_dynamics(lane, green, dt);
+    for (int i = 0; i < n; i++)
+    {
+        Vehicle v = dequeue(queue);
+        if (i < maxCleared)
+            cleared[i] = v;
+    }
+    remove_front_vehicles(lane, n);
+    return n;
+}
@@ -0,0 +1,42 @@
+#ifndef DYNAMICS_H
+#define DYNAMICS_H
+
+#include <stdbool.h>
+#include "queue.h"
+
+// Intelligent Driver Model parameters (urban car, SI units)
+#define DYN_VEHICLE_LENGTH 4.5f  // m
+#define DYN_MIN_GAP 2.0f         // s0: standstill bumper-to-bumper gap (m)
+#define DYN_TIME_HEADWAY 1.5f    // T: desired time gap to the leader (s)
+#define DYN_MAX_ACCEL 1.5f       // a (m/s^2)
+#define DYN_COMFORT_DECEL 2.0f   // b (m/s^2)
+#define DYN_MAX_DECEL 8.0f       // Physical braking limit (m/s^2)
+#define DYN_DESIRED_SPEED 13.9f  // v0: 50 km/h (m/s)
+#define DYN_CLEAR_DISTANCE 30.0f // Distance past the stop line at which a vehicle has left the junction (m)
+#define DYN_STEP_SECONDS 0.05f   // Integration step (s)
+#define DYN_STOP_SPEED 0.01f     // Below this speed, without real acceleration, a vehicle is at rest (m/s)
+#define DYN_STOP_ACCEL 0.05f     // (m/s^2); a standing queue settles within ~3cm of its standstill gaps
+
+// Per-lane vehicle kinematics stored as structure-of-arrays so the step loop
+// vectorizes. Index i matches the i-th vehicle of the lane's Queue (0 = front).
+// Positions are measured along the direction of travel relative to the stop
+// line: negative while waiting, positive once inside the junction.
+typedef struct
+{
+    _Alignas(32) float pos[MAX_QUEUE_SIZE];
+    _Alignas(32) float vel[MAX_QUEUE_SIZE];
+    _Alignas(32) float acc[MAX_QUEUE_SIZE];
+    int count;
+    int moving; // Vehicles with nonzero speed, kept up to date by every call below
+} LaneDynamics;
+
+void init_lane_dynamics(LaneDynamics *lane);
+void add_vehicle_dynamics(LaneDynamics *lane);
+void insert_vehicle_dynamics(LaneDynamics *lane, int index);
+int committed_vehicles(const LaneDynamics *lane);
+int step_lane_dynamics(LaneDynamics *lane, bool green, float dt);
+void remove_front_vehicles(LaneDynamics *lane, int n);
+bool lane_is_moving(const LaneDynamics *lane);
+int advance_lane(LaneDynamics *lane, Queue *queue, bool green, float dt, Vehicle *cleared, int maxCleared);
+
+#endif
@@ -0,0 +1,346 @@
+#include "ingest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+bool ingest_init(IngestHub *hub, int numShards)
+{
+    hub->shards = calloc(numShards, sizeof(Shard));
+    if (!hub->shards)
+    {
+        fprintf(stderr, "Out of memory for %d input shards\n", numShards);
+        return false;
+    }
+    hub->numShards = numShards;
+    snprintf(hub->session, sizeof(hub->session), "%ld-%d", (long)time(NULL), (int)getpid());
+
+    for (int i = 0; i < NUM_LANES; i++)
+        atomic_init(&hub->laneFree[i], MAX_QUEUE_SIZE);
+
+    for (int k = 0; k < numShards; k++)
+    {
+        Shard *shard = &hub->shards[k];
+        shard->hub = hub;
+        shard->id = k;
+        shard_file_name(shard->path, sizeof(shard->path), VEHICLE_BASE_FILE, k);
+        shard_file_name(shard->creditsPath, sizeof(shard->creditsPath), CREDITS_BASE_FILE, k);
+        snprintf(shard->creditsTmpPath, sizeof(shard->creditsTmpPath), "%s.tmp", shard->creditsPath);
+        for (int i = 0; i < NUM_LANES; i++)
+        {
+            atomic_init(&shard->lanes[i].head, 0);
+            atomic_init(&shard->lanes[i].tail, 0);
+        }
+        atomic_init(&shard->returned, 0);
+        atomic_init(&shard->malformed, 0);
+        atomic_init(&shard->watermark, 0);
+    }
+    return true;
+}
+
+void ingest_free(IngestHub *hub)
+{
+    free(hub->shards);
+    hub->shards = NULL;
+    hub->numShards = 0;
+}
+
+uint64_t ingest_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts); // Wall clock, so producers' stamps are comparable
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static unsigned ring_length(ShardLaneRing *ring)
+{
+    return atomic_load_explicit(&ring->tail, memory_order_acquire) -
+           atomic_load_explicit(&ring->head, memory_order_acquire);
+}
+
+static bool ring_push(ShardLaneRing *ring, const ShardRecord *record)
+{
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail - head == SHARD_LANE_CAPACITY)
+        return false;
+
+    ring->items[tail & (SHARD_LANE_CAPACITY - 1)] = *record;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+static const ShardRecord *ring_peek(ShardLaneRing *ring)
+{
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head == tail ? NULL : &ring->items[head & (SHARD_LANE_CAPACITY - 1)];
+}
+
+static void ring_pop(ShardLaneRing *ring)
+{
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// Parses "ID:Road:Lane[:Timestamp][:Class]"; any lane other than 1 or 2 maps
+// to lane 3
+static bool parse_record(char *line, uint64_t nowMs, ShardRecord *record, int *laneIndex)
+{
+    char *vehicleNumber = strtok(line, ":");
+    char *road = strtok(NULL, ":");
+    char *laneStr = strtok(NULL, ":");
+    char *stamp = strtok(NULL, ":");
+    char *classStr = strtok(NULL, ":");
+
+    if (!vehicleNumber || !road || !laneStr || *road < 'A' || *road > 'D')
+        return false;
+
+    // Records without a timestamp may still carry a class
+    if (stamp && !classStr && (*stamp < '0' || *stamp > '9'))
+    {
+        classStr = stamp;
+        stamp = NULL;
+    }
+
+    VehicleClass vehicleClass = VEHICLE_NORMAL;
+    if (classStr)
+    {
+        const char *found = strchr(VEHICLE_CLASS_CODES, *classStr);
+        if (!found || *classStr == '\0' || classStr[1] != '\0')
+            return false;
+        vehicleClass = (VehicleClass)(found - VEHICLE_CLASS_CODES);
+    }
+
+    Vehicle *v = &record->vehicle;
+    strncpy(v->vehicle_id, vehicleNumber, sizeof(v->vehicle_id) - 1);
+    v->vehicle_id[sizeof(v->vehicle_id) - 1] = '\0';
+    v->road = *road;
+    v->lane = atoi(laneStr);
+    v->arrival_time = 0.0; // Stamped by the simulator when it enqueues
+    v->vehicle_class = vehicleClass;
+    record->timestamp = stamp ? strtoull(stamp, NULL, 10) : nowMs;
+
+    *laneIndex = (*road - 'A') * 3 + ((v->lane == 1) ? 0 : (v->lane == 2) ? 1 : 2);
+    return true;
+}
+
+// Advertises this shard's credits: an equal share of each lane's space that
+// is neither queued nor already sitting in some shard's ring. The file is
+// only rewritten when an accepted count or a share has changed.
+static void write_credits(Shard *shard)
+{
+    IngestHub *hub = shard->hub;
+    int share[NUM_LANES];
+    bool changed = !shard->published;
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        int space = atomic_load_explicit(&hub->laneFree[i], memory_order_acquire);
+        for (int k = 0; k < hub->numShards; k++)
+            space -= ring_length(&hub->shards[k].lanes[i]);
+
+        share[i] = 0;
+        if (space > 0)
+            share[i] = space / hub->numShards + (shard->id < space % hub->numShards ? 1 : 0);
+        changed = changed || share[i] != shard->publishedShare[i] ||
+                  shard->accepted[i] != shard->publishedAccepted[i];
+    }
+    if (!changed)
+        return;
+
+    FILE *file = fopen(shard->creditsTmpPath, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to write %s: %s\n", shard->creditsTmpPath, strerror(errno));
+        return;
+    }
+
+    fprintf(file, "%s %s", CREDITS_TAG, hub->session);
+    for (int i = 0; i < NUM_LANES; i++)
+        fprintf(file, " %lu", shard->accepted[i]);
+    for (int i = 0; i < NUM_LANES; i++)
+        fprintf(file, " %d", share[i]);
+    fprintf(file, "\n");
+
+    if (fclose(file) != 0 || rename(shard->creditsTmpPath, shard->creditsPath) != 0)
+    {
+        fprintf(stderr, "Failed to publish %s: %s\n", shard->creditsPath, strerror(errno));
+        return;
+    }
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        shard->publishedAccepted[i] = shard->accepted[i];
+        shard->publishedShare[i] = share[i];
+    }
+    shard->published = true;
+}
+
+// Moves every record in the shard's file into its per-lane rings without
+// touching the simulator's mutex, then refreshes the shard's credits.
+// Records whose ring is full are written back to the file for the next
+// pass. Returns the number of records taken, or -1 if the file is missing.
+int ingest_parse_shard(Shard *shard, uint64_t nowMs)
+{
+    FILE *file = fopen(shard->path, "r+");
+    if (!file)
+    {
+        write_credits(shard);
+        atomic_store_explicit(&shard->watermark, nowMs, memory_order_release);
+        return -1;
+    }
+
+    // Producers append under the same lock, so nothing lands between our
+    // last read and the truncate below
+    flock(fileno(file), LOCK_EX);
+
+    ShardRecord *kept = NULL;
+    int numKept = 0, keptCapacity = 0;
+    int taken = 0;
+    bool sawLines = false;
+    char line[100];
+
+    while (fgets(line, sizeof(line), file))
+    {
+        line[strcspn(line, "\n")] = 0;
+        if (strlen(line) == 0)
+            continue;
+        sawLines = true;
+
+        char original[sizeof(line)];
+        memcpy(original, line, sizeof(line));
+
+        ShardRecord record;
+        int laneIndex;
+        if (!parse_record(line, nowMs, &record, &laneIndex))
+        {
+            fprintf(stderr, "⚠️  Skipping malformed vehicle record in %s: %s\n", shard->path, original);
+            atomic_fetch_add(&shard->malformed, 1);
+            continue;
+        }
+
+        if (ring_push(&shard->lanes[laneIndex], &record))
+        {
+            shard->accepted[laneIndex]++;
+            taken++;
+            continue;
+        }
+
+        // Lane backlog is full: a producer ignored its credits
+        if (numKept == keptCapacity)
+        {
+            keptCapacity = keptCapacity ? keptCapacity * 2 : 16;
+            ShardRecord *grown = realloc(kept, sizeof(ShardRecord) * keptCapacity);
+            if (!grown)
+            {
+                fprintf(stderr, "Out of memory, %s dropped %s\n", shard->path, record.vehicle.vehicle_id);
+                continue;
+            }
+            kept = grown;
+        }
+        kept[numKept++] = record;
+    }
+
+    // Leave only the records that did not fit
+    if (sawLines)
+    {
+        rewind(file);
+        if (ftruncate(fileno(file), 0) != 0)
+            fprintf(stderr, "Failed to clear %s: %s\n", shard->path, strerror(errno));
+        for (int i = 0; i < numKept; i++)
+            fprintf(file, "%s:%c:%d:%llu:%c\n", kept[i].vehicle.vehicle_id, kept[i].vehicle.road,
+                    kept[i].vehicle.lane, (unsigned long long)kept[i].timestamp,
+                    VEHICLE_CLASS_CODES[kept[i].vehicle.vehicle_class]);
+        fflush(file);
+    }
+    flock(fileno(file), LOCK_UN);
+    fclose(file);
+    free(kept);
+
+    if (numKept > 0)
+    {
+        atomic_fetch_add(&shard->returned, numKept);
+        printf("⚠️  %d vehicles arrived for full lanes, kept in %s for retry\n", numKept, shard->path);
+    }
+
+    write_credits(shard);
+    atomic_store_explicit(&shard->watermark, nowMs, memory_order_release);
+    return taken;
+}
+
+// Called by the consumer whenever a lane's queue shrinks
+void ingest_set_lane_free(IngestHub *hub, int lane, int freeSlots)
+{
+    atomic_store_explicit(&hub->laneFree[lane], freeSlots, memory_order_release);
+}
+
+// Pops up to `space` records for one lane from all shards, oldest timestamp
+// first, into `out`. Records newer than the slowest shard's last parse are
+// held back, since that shard may still deliver older ones. Only the
+// simulation thread may call this.
+int ingest_merge_lane(IngestHub *hub, int lane, int space, ShardRecord *out)
+{
+    int available = 0;
+    uint64_t watermark = UINT64_MAX;
+    for (int k = 0; k < hub->numShards; k++)
+    {
+        Shard *shard = &hub->shards[k];
+        uint64_t parsed = atomic_load_explicit(&shard->watermark, memory_order_acquire);
+        if (parsed < watermark)
+            watermark = parsed;
+        available += ring_length(&shard->lanes[lane]);
+    }
+    int limit = available < space ? available : space;
+
+    // Publish the reduced space before the rings shrink, so a parser computing
+    // credits in between under- rather than over-estimates
+    ingest_set_lane_free(hub, lane, space - limit);
+
+    int n = 0;
+    while (n < limit)
+    {
+        ShardLaneRing *oldest = NULL;
+        const ShardRecord *oldestRecord = NULL;
+        for (int k = 0; k < hub->numShards; k++)
+        {
+            const ShardRecord *record = ring_peek(&hub->shards[k].lanes[lane]);
+            if (record && (!oldestRecord || record->timestamp < oldestRecord->timestamp))
+            {
+                oldest = &hub->shards[k].lanes[lane];
+                oldestRecord = record;
+            }
+        }
+        if (oldestRecord->timestamp > watermark)
+            break;
+        out[n++] = *oldestRecord;
+        ring_pop(oldest);
+    }
+
+    if (n < limit)
+        ingest_set_lane_free(hub, lane, space - n);
+    return n;
+}
+
+unsigned long ingest_total_returned(IngestHub *hub)
+{
+    unsigned long total = 0;
+    for (int k = 0; k < hub->numShards; k++)
+        total += atomic_load(&hub->shards[k].returned);
+    return total;
+}
+
+// Whether any shard's rings hold records not yet merged
+bool ingest_pending(IngestHub *hub)
+{
+    for (int k = 0; k < hub->numShards; k++)
+    {
+        for (int i = 0; i < NUM_LANES; i++)
+        {
+            if (ring_length(&hub->shards[k].lanes[i]) > 0)
+                return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,64 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "queue.h"
+#include "scheduler.h"
+#include "credits.h"
+
+#define SHARD_LANE_CAPACITY 256 // Per shard and lane; power of two, above MAX_QUEUE_SIZE
+
+typedef struct
+{
+    Vehicle vehicle;
+    uint64_t timestamp; // Producer clock in ms, or parse time if the record had none
+} ShardRecord;
+
+// Single-producer/single-consumer ring: the shard's parser pushes, the
+// simulation thread pops. Indices only grow; slots are index & (capacity-1).
+typedef struct
+{
+    ShardRecord items[SHARD_LANE_CAPACITY];
+    _Alignas(64) atomic_uint head; // Next record to pop (consumer)
+    _Alignas(64) atomic_uint tail; // Next free slot (producer)
+} ShardLaneRing;
+
+struct IngestHub;
+
+typedef struct
+{
+    struct IngestHub *hub;
+    int id;
+    char path[64];
+    char creditsPath[64];
+    char creditsTmpPath[72];
+    ShardLaneRing lanes[NUM_LANES];
+    unsigned long accepted[NUM_LANES]; // Parser-owned: vehicles taken from the file per lane
+    unsigned long publishedAccepted[NUM_LANES]; // Parser-owned: last credits file written
+    int publishedShare[NUM_LANES];
+    bool published;
+    atomic_ulong returned;             // Written back because the ring was full
+    atomic_ulong malformed;
+    _Atomic uint64_t watermark; // Start time of the last completed parse pass (ms)
+} Shard;
+
+typedef struct IngestHub
+{
+    Shard *shards;
+    int numShards;
+    char session[32];
+    atomic_int laneFree[NUM_LANES]; // Queue space not yet promised to any ring
+} IngestHub;
+
+bool ingest_init(IngestHub *hub, int numShards);
+void ingest_free(IngestHub *hub);
+uint64_t ingest_now_ms(void);
+int ingest_parse_shard(Shard *shard, uint64_t nowMs);
+void ingest_set_lane_free(IngestHub *hub, int lane, int freeSlots);
+int ingest_merge_lane(IngestHub *hub, int lane, int space, ShardRecord *out);
+unsigned long ingest_total_returned(IngestHub *hub);
+bool ingest_pending(IngestHub *hub);
+
+#endif
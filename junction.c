@@ -0,0 +1,210 @@
+#include "junction.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+Junction *junction_create(const SchedulerParams *params)
+{
+    Junction *junction = malloc(sizeof(Junction));
+    if (!junction)
+    {
+        fprintf(stderr, "Out of memory for a junction\n");
+        return NULL;
+    }
+    junction_init(junction, params);
+    return junction;
+}
+
+// Empties every lane and resets the clock and counters. `params` may be NULL
+// for the simulator's defaults; it is copied.
+void junction_init(Junction *junction, const SchedulerParams *params)
+{
+    Queue *lanes[NUM_LANES];
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        init_queue(&junction->lanes[i]);
+        init_lane_dynamics(&junction->dynamics[i]);
+        lanes[i] = &junction->lanes[i];
+    }
+    initializePriorityQueue(junction->priorityQueue, lanes);
+
+    junction->sched = (SchedulerState){0, 0, 0, 0, false, 0, 0, 0, 0};
+    junction->params = params ? *params : DEFAULT_SCHEDULER_PARAMS;
+    junction->ticks = 0;
+    junction->time = 0.0;
+    junction->lastPhaseTime = -junction->params.time_per_vehicle;
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        junction->lane_served[i] = 0;
+        junction->emergency_since[i] = 0.0;
+    }
+    junction->total_arrived = 0;
+    junction->total_served = 0;
+    junction->total_dropped = 0;
+    junction->emergency_waiting = 0;
+    junction->emergency_greens = 0;
+    junction->emergency_latency_total = 0.0;
+    junction->emergency_latency_max = 0.0f;
+    junction->emergency_latency_last = 0.0f;
+    junction->on_departure = NULL;
+    junction->on_schedule = NULL;
+    junction->user = NULL;
+}
+
+void junction_destroy(Junction *junction)
+{
+    free(junction);
+}
+
+// Lane index for a road letter and lane number, as the ingest parser maps
+// them: any lane other than 1 or 2 is lane 3. Returns -1 for an unknown road.
+int junction_lane_index(char road, int lane)
+{
+    if (road < 'A' || road > 'D')
+        return -1;
+    return (road - 'A') * 3 + ((lane == 1) ? 0 : (lane == 2) ? 1 : 2);
+}
+
+// Queues a batch of vehicles at the current junction time. Each keeps its
+// arrival_time, which should be on the junction's clock and may be earlier
+// than its time when the caller knows the vehicle was delayed on the way in;
+// emergency preemption latency is measured from it. Buses and emergency
+// vehicles move up past lower classes, but not past vehicles already
+// committed to the junction. Vehicles for a full lane or an unknown road are
+// refused and counted in total_dropped. Returns the number queued.
+int junction_push_arrivals(Junction *junction, const Vehicle *batch, int n)
+{
+    int perLane[NUM_LANES] = {0};
+    int accepted = 0;
+
+    for (int k = 0; k < n; k++)
+    {
+        int i = junction_lane_index(batch[k].road, batch[k].lane);
+        int position = i < 0 ? -1 : enqueue_by_class(&junction->lanes[i], batch[k], committed_vehicles(&junction->dynamics[i]));
+        if (position < 0)
+        {
+            junction->total_dropped++;
+            continue;
+        }
+        insert_vehicle_dynamics(&junction->dynamics[i], position);
+        perLane[i]++;
+        accepted++;
+
+        if (batch[k].vehicle_class == VEHICLE_EMERGENCY)
+        {
+            updateEmergencyMask(&junction->sched, i, &junction->lanes[i]);
+            if (!(junction->emergency_waiting & (1u << i)))
+            {
+                junction->emergency_waiting |= 1u << i;
+                junction->emergency_since[i] = batch[k].arrival_time;
+            }
+        }
+    }
+
+    // One rate update per lane: within a batch every arrival shares a timestamp
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        if (perLane[i] > 0)
+            record_arrivals(&junction->priorityQueue[i].arrivals, perLane[i], junction->time);
+    }
+    junction->total_arrived += accepted;
+    return accepted;
+}
+
+// Closes the latency sample of the green lane if an emergency vehicle there
+// was still waiting for it
+static void record_emergency_green(Junction *junction)
+{
+    int light = junction->sched.currentLight;
+    if (light == 0 || !(junction->emergency_waiting & (1u << (light - 1))))
+        return;
+
+    float latency = (float)(junction->time - junction->emergency_since[light - 1]);
+    junction->emergency_waiting &= ~(1u << (light - 1));
+    junction->emergency_greens++;
+    junction->emergency_latency_total += latency;
+    junction->emergency_latency_last = latency;
+    if (latency > junction->emergency_latency_max)
+        junction->emergency_latency_max = latency;
+}
+
+static int step_tick(Junction *junction)
+{
+    SchedulerState *sched = &junction->sched;
+    const SchedulerParams *params = &junction->params;
+    double now = junction->time;
+    int served = 0;
+
+    // Emergency vehicles preempt the phase on the first tick after they
+    // arrive, without waiting for the scheduler or the minimum green
+    bool wasPreempted = sched->preempted_lane != 0;
+    bool preempted = checkEmergencyPreemption(sched) > 0;
+    if (wasPreempted && !preempted)
+        junction->lastPhaseTime = now - params->time_per_vehicle; // Re-evaluate at the next scheduler tick
+
+    if (junction->ticks % JUNCTION_SCHEDULER_TICKS == 0)
+    {
+        if (junction->on_schedule)
+            junction->on_schedule(junction->user, false);
+        updatePriorityQueue(junction->priorityQueue, sched, params);
+        if (!preempted)
+        {
+            checkEmergencyOverflow(junction->priorityQueue, sched, params);
+
+            // Hold each green for at least one phase before re-evaluating
+            if (now - junction->lastPhaseTime >= params->time_per_vehicle &&
+                planGreenLane(junction->priorityQueue, sched, params, junction->dynamics, now) > 0)
+                junction->lastPhaseTime = now;
+        }
+        if (junction->on_schedule)
+            junction->on_schedule(junction->user, true);
+    }
+    record_emergency_green(junction);
+
+    // Discharge emerges from the vehicle motion; only the green lane may pass
+    // its stop line. A lane never clears more than it holds, so `cleared`
+    // receives every departing vehicle.
+    Vehicle cleared[MAX_QUEUE_SIZE];
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        if (junction->dynamics[i].count == 0)
+            continue;
+
+        int n = advance_lane(&junction->dynamics[i], &junction->lanes[i], sched->currentLight == i + 1,
+                             JUNCTION_TICK_SECONDS, cleared, MAX_QUEUE_SIZE);
+        if (n == 0)
+            continue;
+
+        served += n;
+        junction->lane_served[i] += n;
+        updateEmergencyMask(sched, i, &junction->lanes[i]);
+        if (junction->on_departure)
+        {
+            for (int k = 0; k < n; k++)
+                junction->on_departure(junction->user, i, &cleared[k], now);
+        }
+    }
+
+    junction->total_served += served;
+    junction->ticks++;
+    junction->time = junction->ticks * (double)JUNCTION_TICK_SECONDS;
+    return served;
+}
+
+// Advances the junction by n_ticks fixed ticks of JUNCTION_TICK_SECONDS.
+// Returns the number of vehicles that cleared the junction meanwhile.
+int junction_step(Junction *junction, int n_ticks)
+{
+    int served = 0;
+    for (int t = 0; t < n_ticks; t++)
+        served += step_tick(junction);
+    return served;
+}
+
+JunctionLaneView junction_lane_view(const Junction *junction, int lane)
+{
+    const Queue *queue = &junction->lanes[lane];
+    const LaneDynamics *dynamics = &junction->dynamics[lane];
+    JunctionLaneView view = {queue->items, queue->front, queue->count,
+                             dynamics->pos, dynamics->vel, junction->sched.currentLight == lane + 1};
+    return view;
+}
@@ -0,0 +1,69 @@
+#ifndef JUNCTION_H
+#define JUNCTION_H
+
+#include <stdbool.h>
+#include "queue.h"
+#include "scheduler.h"
+#include "dynamics.h"
+
+#define JUNCTION_TICK_SECONDS DYN_STEP_SECONDS // Simulated time per junction_step() tick
+#define JUNCTION_SCHEDULER_TICKS 4            // The scheduler re-evaluates every 200ms
+
+// Called once per vehicle that drives clear of the junction; `now` is the
+// start of the tick it cleared in
+typedef void (*JunctionDepartureFn)(void *user, int lane, const Vehicle *vehicle, double now);
+
+// Called with done = false just before each scheduler run and done = true
+// just after it, e.g. to time the scheduler apart from the vehicle physics
+typedef void (*JunctionScheduleFn)(void *user, bool done);
+
+// One junction's queues, vehicle dynamics and scheduler, with no globals,
+// threads or SDL, so callers can run any number of them in-process. Lanes are
+// indexed 0-11 as road * 3 + lane - 1. The scheduler keeps pointers into
+// `lanes`, so a Junction must not be copied or moved once initialised.
+typedef struct
+{
+    Queue lanes[NUM_LANES];
+    LaneDynamics dynamics[NUM_LANES];
+    PriorityQueueItem priorityQueue[NUM_LANES];
+    SchedulerState sched;
+    SchedulerParams params;
+    long ticks;
+    double time; // Simulated seconds, ticks * JUNCTION_TICK_SECONDS; double so long runs keep 50ms resolution
+    double lastPhaseTime;
+    unsigned long lane_served[NUM_LANES];
+    unsigned long total_arrived;
+    unsigned long total_served;
+    unsigned long total_dropped;       // Arrivals refused because their lane was full
+    unsigned emergency_waiting;        // Lanes whose emergency vehicle has not had a green yet
+    double emergency_since[NUM_LANES]; // Arrival time of that vehicle
+    unsigned long emergency_greens;
+    double emergency_latency_total;
+    float emergency_latency_max;
+    float emergency_latency_last;
+    JunctionDepartureFn on_departure; // Optional
+    JunctionScheduleFn on_schedule;   // Optional
+    void *user;
+} Junction;
+
+// A lane's state read in place, without copying. Valid until the next push
+// or step on its junction.
+typedef struct
+{
+    const Vehicle *items; // Ring of MAX_QUEUE_SIZE; vehicle k is items[(front + k) % MAX_QUEUE_SIZE]
+    int front;
+    int count;
+    const float *pos; // Vehicle k's position relative to the stop line (m), front first
+    const float *vel; // Vehicle k's speed (m/s)
+    bool green;
+} JunctionLaneView;
+
+Junction *junction_create(const SchedulerParams *params);
+void junction_init(Junction *junction, const SchedulerParams *params);
+void junction_destroy(Junction *junction);
+int junction_lane_index(char road, int lane);
+int junction_push_arrivals(Junction *junction, const Vehicle *batch, int n);
+int junction_step(Junction *junction, int n_ticks);
+JunctionLaneView junction_lane_view(const Junction *junction, int lane);
+
+#endif
@@ -7,6 +7,7 @@ void init_queue(Queue *q)
     q->rear = -1;
     q->count = 0;
     q->priority = 0;
+    memset(q->class_count, 0, sizeof(q->class_count));
 }
 
 int is_empty(Queue *q)
@@ -26,17 +27,44 @@ void enqueue(Queue *q, Vehicle vehicle)
         q->rear = (q->rear + 1) % MAX_QUEUE_SIZE;
         memcpy(&q->items[q->rear], &vehicle, sizeof(Vehicle));
         q->count++;
+        q->class_count[vehicle.vehicle_class]++;
     }
 }
 
+// Inserts the vehicle behind every queued vehicle of its class or higher,
+// i.e. ahead of all lower classes, but never before position min_position
+// (vehicles already committed to the junction). Returns the position taken,
+// 0 being the front, or -1 if the queue is full. Normal vehicles always go
+// to the back, so only higher classes pay for the shift.
+int enqueue_by_class(Queue *q, Vehicle vehicle, int min_position)
+{
+    if (is_full(q))
+        return -1;
+
+    int position = q->count;
+    while (position > min_position &&
+           q->items[(q->front + position - 1) % MAX_QUEUE_SIZE].vehicle_class < vehicle.vehicle_class)
+        position--;
+
+    for (int i = q->count; i > position; i--)
+        q->items[(q->front + i) % MAX_QUEUE_SIZE] = q->items[(q->front + i - 1) % MAX_QUEUE_SIZE];
+
+    q->items[(q->front + position) % MAX_QUEUE_SIZE] = vehicle;
+    q->rear = (q->rear + 1) % MAX_QUEUE_SIZE;
+    q->count++;
+    q->class_count[vehicle.vehicle_class]++;
+    return position;
+}
+
 Vehicle dequeue(Queue *q)
 {
-    Vehicle empty = {"", ' ', 0};
+    Vehicle empty = {"", ' ', 0, 0.0f, VEHICLE_NORMAL};
     if (!is_empty(q))
     {
         Vehicle item = q->items[q->front];
         q->front = (q->front + 1) % MAX_QUEUE_SIZE;
         q->count--;
+        q->class_count[item.vehicle_class]--;
         return item;
     }
     return empty;
@@ -47,6 +75,11 @@ int get_count(Queue *q)
     return q->count;
 }
 
+int get_class_count(Queue *q, VehicleClass vehicle_class)
+{
+    return q->class_count[vehicle_class];
+}
+
 void set_priority(Queue *q, int priority)
 {
     q->priority = priority;
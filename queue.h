@@ -3,10 +3,21 @@
 
 #define MAX_QUEUE_SIZE 200
 
+// Service levels, lowest first. A lane's queue keeps each level as one
+// contiguous run: emergency vehicles, then buses, then everything else.
+typedef enum {
+    VEHICLE_NORMAL,
+    VEHICLE_BUS,
+    VEHICLE_EMERGENCY,
+    VEHICLE_CLASSES
+} VehicleClass;
+
 typedef struct {
     char vehicle_id[9];
     char road;
     int lane;
+    double arrival_time; // Seconds, stamped when the vehicle is enqueued
+    VehicleClass vehicle_class;
 } Vehicle;
 
 typedef struct {
@@ -15,14 +26,17 @@ typedef struct {
     int rear;
     int count;
     int priority;
+    int class_count[VEHICLE_CLASSES];
 } Queue;
 
 void init_queue(Queue *q);
 int is_empty(Queue *q);
 int is_full(Queue *q);
 void enqueue(Queue *q, Vehicle vehicle);
+int enqueue_by_class(Queue *q, Vehicle vehicle, int min_position);
 Vehicle dequeue(Queue *q);
 int get_count(Queue *q);
+int get_class_count(Queue *q, VehicleClass vehicle_class);
 void set_priority(Queue *q, int priority);
 int get_priority(Queue *q);
 
@@ -0,0 +1,294 @@
+#include "scheduler.h"
+#include <stdio.h>
+#include <float.h>
+
+#define AL2_INDEX 1
+
+const SchedulerParams DEFAULT_SCHEDULER_PARAMS = {
+    EMERGENCY_THRESHOLD,
+    HIGH_PRIORITY_THRESHOLD,
+    NORMAL_PRIORITY_THRESHOLD,
+    PRIORITY_COOLDOWN,
+    TIME_PER_VEHICLE,
+    LOOKAHEAD_PHASES,
+    LOOKAHEAD_BUDGET};
+
+// State of one depth-limited search over phase sequences
+typedef struct
+{
+    float rate[NUM_LANES];
+    int candidates[NUM_LANES]; // Lanes worth a green, most vehicles first
+    int numCandidates;
+    float phase; // Seconds per planned phase
+    int depth;
+    int steps;
+    int budget;
+    bool exhausted;
+    float bestCost;
+    int bestFirst;
+} LookaheadSearch;
+
+void initializePriorityQueue(PriorityQueueItem priorityQueue[NUM_LANES], Queue *const lanes[NUM_LANES])
+{
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        priorityQueue[i] = (PriorityQueueItem){lanes[i], 0, i / 3, i % 3 + 1, {0.0f, 0.0f}};
+    }
+    priorityQueue[AL2_INDEX].priority = 1; // AL2 starts with priority 1
+}
+
+void updatePriorityQueue(PriorityQueueItem priorityQueue[NUM_LANES], SchedulerState *state, const SchedulerParams *params)
+{
+    int al2_count = get_count(priorityQueue[AL2_INDEX].queue);
+
+    // High Priority Mode Logic (from assignment spec)
+    if (al2_count > params->high_priority_threshold) // >10 vehicles
+    {
+        if (!state->high_priority_mode && state->verbose)
+        {
+            printf("🔴 HIGH PRIORITY MODE ACTIVATED - AL2 has %d vehicles\n", al2_count);
+        }
+        state->high_priority_mode = 1;
+        state->priority_cooldown = params->priority_cooldown;
+    }
+    else if (al2_count < params->normal_priority_threshold) // <5 vehicles
+    {
+        if (state->high_priority_mode && state->verbose)
+        {
+            printf("🟢 HIGH PRIORITY MODE DEACTIVATED - AL2 has %d vehicles\n", al2_count);
+        }
+        state->high_priority_mode = 0;
+        state->priority_cooldown = 0;
+    }
+
+    // Update priorities
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        int count = get_count(priorityQueue[i].queue);
+        if (i == AL2_INDEX && state->high_priority_mode)
+        {
+            priorityQueue[i].priority = 1000; // Highest priority
+        }
+        else
+        {
+            priorityQueue[i].priority = count; // Normal priority based on queue length
+        }
+    }
+}
+
+int findMostCongestedLane(PriorityQueueItem priorityQueue[NUM_LANES])
+{
+    int maxCount = 0;
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        if (i != AL2_INDEX) // Skip AL2 in normal congestion check
+        {
+            int count = get_count(priorityQueue[i].queue);
+            if (count > maxCount)
+                maxCount = count;
+        }
+    }
+    return maxCount;
+}
+
+void checkEmergencyOverflow(PriorityQueueItem priorityQueue[NUM_LANES], SchedulerState *state, const SchedulerParams *params)
+{
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        int count = get_count(priorityQueue[i].queue);
+        if (count > params->emergency_threshold)
+        {
+            if (state->verbose)
+                printf("🚨 EMERGENCY OVERFLOW: Lane %d has %d vehicles\n", i + 1, count);
+            state->emergency_override = 1;
+            state->currentLight = i + 1;
+            return;
+        }
+    }
+    state->emergency_override = 0;
+}
+
+int getHighestPriorityLane(PriorityQueueItem priorityQueue[NUM_LANES])
+{
+    int maxPriority = -1;
+    int selectedLane = 0;
+
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        if (!is_empty(priorityQueue[i].queue))
+        {
+            if (priorityQueue[i].priority > maxPriority)
+            {
+                maxPriority = priorityQueue[i].priority;
+                selectedLane = i + 1;
+            }
+        }
+    }
+    return selectedLane;
+}
+
+// Picks the lane that gets the green for the next phase and switches the
+// light to it. Returns the lane (1-12) or 0 when every light stays red.
+int selectGreenLane(PriorityQueueItem priorityQueue[NUM_LANES], SchedulerState *state)
+{
+    if (state->high_priority_mode && !state->emergency_override)
+    {
+        // HIGH PRIORITY MODE: Serve AL2 first
+        bool waiting = !is_empty(priorityQueue[AL2_INDEX].queue);
+        state->currentLight = waiting ? AL2_INDEX + 1 : 0; // All red if the priority lane is empty
+        return state->currentLight;
+    }
+
+    // NORMAL MODE: Serve highest priority lane (0 when every lane is empty)
+    state->currentLight = getHighestPriorityLane(priorityQueue);
+    return state->currentLight;
+}
+
+// Projects every lane through one phase in which only `green` is served and
+// returns the vehicle-seconds of waiting it adds. Queues grow at their
+// forecast rate; a newly switched green loses its start-up time.
+static float projectPhase(const LookaheadSearch *search, const float queue[NUM_LANES], int green, bool switched,
+                          float next[NUM_LANES])
+{
+    float cost = 0.0f;
+    float capacity = LOOKAHEAD_SATURATION_FLOW * (search->phase - (switched ? LOOKAHEAD_LOST_TIME : 0.0f));
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        float end = queue[i] + search->rate[i] * search->phase;
+        if (i == green && capacity > 0.0f)
+            end = end > capacity ? end - capacity : 0.0f;
+        cost += 0.5f * (queue[i] + end) * search->phase;
+        next[i] = end;
+    }
+    return cost;
+}
+
+// Branch and bound: delay only grows along a plan, so a partial plan that
+// already costs more than the best complete one is dropped
+static void searchPlans(LookaheadSearch *search, const float queue[NUM_LANES], int light, int level,
+                        float costSoFar, int firstLane)
+{
+    if (level == search->depth)
+    {
+        if (costSoFar < search->bestCost)
+        {
+            search->bestCost = costSoFar;
+            search->bestFirst = firstLane;
+        }
+        return;
+    }
+
+    for (int c = 0; c < search->numCandidates; c++)
+    {
+        if (search->steps == search->budget)
+        {
+            search->exhausted = true;
+            return;
+        }
+        search->steps++;
+
+        int lane = search->candidates[c];
+        float next[NUM_LANES];
+        float cost = costSoFar + projectPhase(search, queue, lane, lane != light, next);
+        if (cost < search->bestCost)
+            searchPlans(search, next, lane, level + 1, cost, level == 0 ? lane : firstLane);
+    }
+}
+
+// Normal-mode choice that plans the next lookahead_phases phases to minimise
+// projected waiting, using each lane's vehicles still short of the stop line
+// and its forecast arrival rate. Deepens one
+// phase at a time and stops at lookahead_budget plan steps, keeping the
+// answer of the deepest search that finished. High-priority mode and the
+// overflow override behave as in selectGreenLane, which is also used when
+// look-ahead is off. Returns the lane (1-12) or 0 for all red.
+int planGreenLane(PriorityQueueItem priorityQueue[NUM_LANES], SchedulerState *state, const SchedulerParams *params,
+                  const LaneDynamics laneDynamics[NUM_LANES], double now)
+{
+    if (params->lookahead_phases <= 0 || (state->high_priority_mode && !state->emergency_override))
+        return selectGreenLane(priorityQueue, state);
+
+    LookaheadSearch search;
+    float queue[NUM_LANES];
+    search.numCandidates = 0;
+    search.phase = params->time_per_vehicle;
+    search.steps = 0;
+    search.budget = params->lookahead_budget > NUM_LANES ? params->lookahead_budget : NUM_LANES;
+
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        // Vehicles already committed to the junction leave whatever the light does
+        queue[i] = (float)(get_count(priorityQueue[i].queue) - committed_vehicles(&laneDynamics[i]));
+        search.rate[i] = arrival_rate(&priorityQueue[i].arrivals, now);
+
+        // Lanes that are empty and not expected to fill within the horizon are never worth a green
+        if (queue[i] < 1.0f && search.rate[i] * search.phase * params->lookahead_phases < 1.0f)
+            continue;
+
+        // Insertion by count, so the first plan tried is longest-queue-first and bounds the rest
+        int c = search.numCandidates++;
+        while (c > 0 && queue[search.candidates[c - 1]] < queue[i])
+        {
+            search.candidates[c] = search.candidates[c - 1];
+            c--;
+        }
+        search.candidates[c] = i;
+    }
+
+    int chosen = 0;
+    state->lookahead_depth = 0;
+    if (search.numCandidates > 0 && queue[search.candidates[0]] >= 1.0f)
+    {
+        for (int depth = 1; depth <= params->lookahead_phases; depth++)
+        {
+            search.depth = depth;
+            search.exhausted = false;
+            search.bestCost = FLT_MAX;
+            search.bestFirst = 0;
+            searchPlans(&search, queue, state->currentLight - 1, 0, 0.0f, 0);
+            if (search.exhausted)
+                break;
+            chosen = search.bestFirst + 1;
+            state->lookahead_depth = depth;
+        }
+    }
+
+    state->lookahead_steps = search.steps;
+    state->currentLight = chosen;
+    return chosen;
+}
+
+// Call after every enqueue or dequeue on a lane (0-11) so the preemption
+// check never has to scan the queues
+void updateEmergencyMask(SchedulerState *state, int laneIndex, Queue *queue)
+{
+    if (get_class_count(queue, VEHICLE_EMERGENCY) > 0)
+        state->emergency_mask |= 1u << laneIndex;
+    else
+        state->emergency_mask &= ~(1u << laneIndex);
+}
+
+// Constant-time emergency vehicle preemption, run every tick before the
+// regular scheduler. Holds the green on the preempted lane until its
+// emergency vehicles are through, then moves to the lowest-numbered lane
+// still holding one. Returns the preempted lane (1-12), or 0 when the
+// regular scheduler is in charge.
+int checkEmergencyPreemption(SchedulerState *state)
+{
+    if (state->emergency_mask == 0)
+    {
+        if (state->preempted_lane && state->verbose)
+            printf("🚑 Preemption released from lane %d\n", state->preempted_lane);
+        state->preempted_lane = 0;
+        return 0;
+    }
+
+    if (!state->preempted_lane || !(state->emergency_mask & (1u << (state->preempted_lane - 1))))
+    {
+        state->preempted_lane = __builtin_ctz(state->emergency_mask) + 1;
+        if (state->verbose)
+            printf("🚑 EMERGENCY VEHICLE: preempting to lane %d\n", state->preempted_lane);
+    }
+    state->currentLight = state->preempted_lane;
+    return state->preempted_lane;
+}
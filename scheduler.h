@@ -0,0 +1,71 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include "queue.h"
+#include "arrivals.h"
+#include "dynamics.h"
+
+#define NUM_LANES 12
+
+// Defaults used by the GUI simulator; sweep overrides them per configuration
+#define TIME_PER_VEHICLE 4.0f // Minimum green before the phase is re-evaluated
+#define PRIORITY_COOLDOWN 10
+#define EMERGENCY_THRESHOLD 15
+#define HIGH_PRIORITY_THRESHOLD 10
+#define NORMAL_PRIORITY_THRESHOLD 5 // Changed from 3 to match assignment spec
+#define LOOKAHEAD_PHASES 3     // Phases planned ahead in normal mode, 0 = longest queue first
+#define LOOKAHEAD_BUDGET 2000  // Plan steps evaluated per decision, at most
+
+// Fluid model of a lane's green, measured from the IDM: a standing queue
+// discharges at ~0.4 veh/s once the first ~2.5s of start-up have passed
+#define LOOKAHEAD_SATURATION_FLOW 0.4f
+#define LOOKAHEAD_LOST_TIME 2.5f
+
+typedef struct
+{
+    int emergency_threshold;
+    int high_priority_threshold;
+    int normal_priority_threshold;
+    int priority_cooldown;
+    float time_per_vehicle; // Phase length; discharge within it comes from the vehicle dynamics
+    int lookahead_phases;
+    int lookahead_budget;
+} SchedulerParams;
+
+typedef struct
+{
+    Queue *queue;
+    int priority;
+    int road;
+    int lane;
+    ArrivalRate arrivals; // Update with record_arrivals() on every enqueue
+} PriorityQueueItem;
+
+typedef struct
+{
+    int currentLight;
+    int high_priority_mode;
+    int priority_cooldown;
+    int emergency_override;
+    bool verbose; // Log mode changes to stdout (off for batch runs)
+    unsigned emergency_mask; // Bit i set while lane i+1 holds an emergency vehicle
+    int preempted_lane;      // Lane (1-12) green for an emergency vehicle, 0 if none
+    int lookahead_steps;     // Plan steps the last look-ahead decision evaluated
+    int lookahead_depth;     // Phases that decision looked ahead
+} SchedulerState;
+
+extern const SchedulerParams DEFAULT_SCHEDULER_PARAMS;
+
+void initializePriorityQueue(PriorityQueueItem priorityQueue[NUM_LANES], Queue *const lanes[NUM_LANES]);
+void updatePriorityQueue(PriorityQueueItem priorityQueue[NUM_LANES], SchedulerState *state, const SchedulerParams *params);
+void checkEmergencyOverflow(PriorityQueueItem priorityQueue[NUM_LANES], SchedulerState *state, const SchedulerParams *params);
+int getHighestPriorityLane(PriorityQueueItem priorityQueue[NUM_LANES]);
+int findMostCongestedLane(PriorityQueueItem priorityQueue[NUM_LANES]);
+int selectGreenLane(PriorityQueueItem priorityQueue[NUM_LANES], SchedulerState *state);
+int planGreenLane(PriorityQueueItem priorityQueue[NUM_LANES], SchedulerState *state, const SchedulerParams *params,
+                  const LaneDynamics laneDynamics[NUM_LANES], double now);
+void updateEmergencyMask(SchedulerState *state, int laneIndex, Queue *queue);
+int checkEmergencyPreemption(SchedulerState *state);
+
+#endif
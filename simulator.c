@@ -2,11 +2,24 @@
 #include <SDL2/SDL_ttf.h>
 #include <stdbool.h>
 #include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <getopt.h>
 #include "queue.h"
+#include "scheduler.h"
+#include "dynamics.h"
+#include "junction.h"
+#include "capture.h"
+#include "telemetry.h"
+#include "ingest.h"
+#include "trace.h"
 
 #define WINDOW_WIDTH 1400
 #define WINDOW_HEIGHT 1000
@@ -16,91 +29,191 @@
 #define VEHICLE_HEIGHT 20
 #define VEHICLE_SPACING 10
 #define LIGHT_RADIUS 12
-#define MAX_VISIBLE_VEHICLES 8
-#define TIME_PER_VEHICLE 4.0f // Increased from 1.0f
+// Screen scale along each road, chosen so a standing queue keeps the original spacing
+#define PIXELS_PER_METER_V ((VEHICLE_HEIGHT + VEHICLE_SPACING) / (DYN_VEHICLE_LENGTH + DYN_MIN_GAP))
+#define PIXELS_PER_METER_H ((VEHICLE_WIDTH + VEHICLE_SPACING) / (DYN_VEHICLE_LENGTH + DYN_MIN_GAP))
+#define STATUS_INTERVAL 5.0f // Seconds between console status reports
+#define FRAME_MS 33       // ~30 FPS while something is animating
+#define MAX_DIRTY_REGIONS (2 * NUM_LANES + 1)
+#define DEFAULT_RECORD_FPS 30
+#define DEFAULT_CAPTURE_WORKERS 2
+#define SHARD_POLL_MS 250 // How often each parser re-reads its shard file
+#define IDLE_WAIT_MS 1000 // Longest the queue thread sleeps on an empty junction
 #define MAIN_FONT "/usr/share/fonts/truetype/freefont/FreeSans.ttf"
-#define PRIORITY_COOLDOWN 10
-#define EMERGENCY_THRESHOLD 15
-#define HIGH_PRIORITY_THRESHOLD 10
-#define NORMAL_PRIORITY_THRESHOLD 5 // Changed from 3 to match assignment spec
+#define MIN_ZOOM 0.05f
+#define MAX_ZOOM 4.0f
+#define ZOOM_STEP 1.25f
+#define WORLD_MARGIN 12000.0f // How far past the original layout the camera may pan (world px)
+#define LOD_DETAIL_ZOOM 0.75f // Plates, windshields and light labels from this zoom up
+#define LOD_BAR_ZOOM 0.3f     // Below this each queue is drawn as one aggregated bar
 
-const char *VEHICLE_FILE = "vehicles.data";
 
+// Guards the junction (below) along with the render state
 typedef struct
 {
-    Queue *queue;
-    int priority;
-    int road;
-    int lane;
-} PriorityQueueItem;
-
-typedef struct
-{
-    int currentLight;
     int nextLight;
     SDL_mutex *mutex;
     float lightTransition;
-    int high_priority_mode;
-    int priority_cooldown;
-    int emergency_override;
     float vehicle_process_timer;       // NEW: Timer for vehicle processing
     int vehicles_processed_this_cycle; // NEW: Track processed vehicles
 } SharedData;
 
-Queue laneA1, laneA2, laneA3;
-Queue laneB1, laneB2, laneB3;
-Queue laneC1, laneC2, laneC3;
-Queue laneD1, laneD2, laneD3;
-PriorityQueueItem priorityQueue[12];
+// Maps the world, which is the original fixed 1400x1000 layout with roads
+// running on past its edges, onto the window
+typedef struct
+{
+    float x, y; // World point at the window's top-left corner
+    float zoom; // Screen pixels per world pixel
+} Camera;
+
+// What the renderer last put on screen, so it can redraw only what changed
+typedef struct
+{
+    Camera camera;
+    SDL_Texture *background; // Static roads and labels, drawn once
+    SDL_Texture *scene;      // Persistent frame that dirty regions are patched into
+    bool fullRedraw;
+    bool needsPresent;
+    bool animating;
+    int lastLight;
+    float lastTransition;
+    int laneFront[NUM_LANES];
+    int laneCount[NUM_LANES];
+    bool laneMoving[NUM_LANES];
+} RenderCache;
+
+// Paces the junction's fixed ticks against a simulation clock, which is wall
+// time in live mode and frame time when recording
+typedef struct
+{
+    float lastStatusTime;
+    float lastStepTime;
+} SimulationClock;
 
-bool initializeSDL(SDL_Window **window, SDL_Renderer **renderer);
+typedef struct
+{
+    const char *recordPath; // NULL for the interactive window
+    int fps;
+    float speed;    // Recording pace relative to real time, 0 = unthrottled
+    float duration; // Simulated seconds to record, 0 = until stopped
+    int workers;
+    bool headless;
+    int shards; // Input files, each with its own parser thread
+    const char *tracePath; // NULL unless span tracing is on
+    const char *telemetryName; // POSIX shm name, one per running simulator
+} RunOptions;
+
+// Lane queues, vehicle dynamics and scheduler (libjunction); guarded by SharedData.mutex
+Junction junction;
+
+// Top-left corner of each lane's traffic light
+const int lightPositions[NUM_LANES][2] = {
+    // Road A (North)
+    {WINDOW_WIDTH / 2 - LANE_WIDTH - LIGHT_RADIUS, 120}, // AL1
+    {WINDOW_WIDTH / 2 - LIGHT_RADIUS, 120},              // AL2
+    {WINDOW_WIDTH / 2 + LANE_WIDTH - LIGHT_RADIUS, 120}, // AL3
+    // Road B (South)
+    {WINDOW_WIDTH / 2 - LANE_WIDTH - LIGHT_RADIUS, WINDOW_HEIGHT - 140}, // BL1
+    {WINDOW_WIDTH / 2 - LIGHT_RADIUS, WINDOW_HEIGHT - 140},              // BL2
+    {WINDOW_WIDTH / 2 + LANE_WIDTH - LIGHT_RADIUS, WINDOW_HEIGHT - 140}, // BL3
+    // Road C (East)
+    {WINDOW_WIDTH - 140, WINDOW_HEIGHT / 2 - LANE_WIDTH - LIGHT_RADIUS}, // CL1
+    {WINDOW_WIDTH - 140, WINDOW_HEIGHT / 2 - LIGHT_RADIUS},              // CL2
+    {WINDOW_WIDTH - 140, WINDOW_HEIGHT / 2 + LANE_WIDTH - LIGHT_RADIUS}, // CL3
+    // Road D (West)
+    {120, WINDOW_HEIGHT / 2 - LANE_WIDTH - LIGHT_RADIUS}, // DL1
+    {120, WINDOW_HEIGHT / 2 - LIGHT_RADIUS},              // DL2
+    {120, WINDOW_HEIGHT / 2 + LANE_WIDTH - LIGHT_RADIUS}  // DL3
+};
+
+// Wakes the render loop when another thread changes what is on screen
+Uint32 stateChangedEvent = (Uint32)-1;
+atomic_bool wakePending = false;
+volatile sig_atomic_t stopRequested = 0;
+
+// Start of the calling thread's current hold on SharedData.mutex, for tracing
+_Thread_local uint64_t lockAcquiredAt;
+_Thread_local const char *lockSite;
+
+// Per-shard parsers and the rings that carry their records to the scheduler
+IngestHub ingestHub;
+
+// Posted by a parser that has taken vehicles, so an idle queue thread wakes
+sem_t arrivalsReady;
+
+// Live state for external monitors (NULL if shared memory is unavailable)
+TelemetrySegment *telemetry = NULL;
+
+bool parseOptions(int argc, char *argv[], RunOptions *options);
+bool initializeSDL(SDL_Window **window, SDL_Renderer **renderer, bool headless);
+int runInteractive(SDL_Renderer *renderer, TTF_Font *font, TTF_Font *largeFont, TTF_Font *smallFont,
+                   SharedData *sharedData, RenderCache *cache);
+int runRecording(SDL_Renderer *renderer, TTF_Font *font, TTF_Font *largeFont, TTF_Font *smallFont,
+                 SharedData *sharedData, RenderCache *cache, const RunOptions *options);
 void displayText(SDL_Renderer *renderer, TTF_Font *font, const char *text, int x, int y, SDL_Color color, bool shadow);
-void drawIntersection(SDL_Renderer *renderer, TTF_Font *font);
-void drawTrafficLight(SDL_Renderer *renderer, bool isGreen, float transition, int x, int y, int road, int lane, TTF_Font *smallFont);
-void drawVehicle(SDL_Renderer *renderer, int x, int y, char road, int lane, const char *plate, TTF_Font *smallFont, float offset);
-void drawQueue(SDL_Renderer *renderer, Queue *queue, int startX, int startY, char road, int lane, TTF_Font *font, float offset, SharedData *sharedData);
+void drawIntersection(SDL_Renderer *renderer, TTF_Font *font, const Camera *camera);
+void drawTrafficLight(SDL_Renderer *renderer, bool isGreen, float transition, int x, int y, int radius, int road, int lane, TTF_Font *smallFont, bool showLabel);
+void drawVehicle(SDL_Renderer *renderer, SDL_Rect body, char road, int lane, VehicleClass vehicleClass, const char *plate, TTF_Font *smallFont, bool detailed);
+void drawQueue(SDL_Renderer *renderer, Queue *queue, LaneDynamics *dynamics, int stopX, int stopY, char road, int lane, TTF_Font *font,
+               const SDL_Rect *region, const Camera *camera);
+void resetCamera(Camera *camera);
+void zoomCamera(Camera *camera, float factor, int screenX, int screenY);
+void panCamera(Camera *camera, int dx, int dy);
 void drawCurrentStatus(SDL_Renderer *renderer, TTF_Font *largeFont, int currentLight);
-void render(SDL_Renderer *renderer, TTF_Font *font, TTF_Font *largeFont, TTF_Font *smallFont, SharedData *sharedData);
+bool initializeRenderCache(SDL_Renderer *renderer, TTF_Font *font, RenderCache *cache);
+void refreshBackground(SDL_Renderer *renderer, TTF_Font *font, RenderCache *cache);
+void render(SDL_Renderer *renderer, TTF_Font *font, TTF_Font *largeFont, TTF_Font *smallFont, SharedData *sharedData, RenderCache *cache);
+void notifyStateChanged(void);
+void logDeparture(void *user, int lane, const Vehicle *vehicle, double now);
+void traceScheduler(void *user, bool done);
+void initSimulationClock(SimulationClock *clock, float now);
+bool advanceSimulation(SimulationClock *clock, float now);
+void lockShared(SharedData *sharedData, const char *site);
+void unlockShared(SharedData *sharedData);
+void updateLightTransition(SharedData *sharedData, float deltaTime);
+void publishTelemetry(float now);
 void *processQueues(void *arg);
-void *readAndParseFile(void *arg);
-void initializePriorityQueue();
-void updatePriorityQueue(SharedData *sharedData);
-void printQueueStatus(SharedData *sharedData);
-int getHighestPriorityLane();
-int findMostCongestedLane(SharedData *sharedData);
-void checkEmergencyOverflow(SharedData *sharedData);
+int drainShards(float now);
+void *shardParser(void *arg);
+void printQueueStatus(void);
 SDL_Color getLaneColor(char road, int lane);
 
-int main()
+int main(int argc, char *argv[])
 {
-    pthread_t tQueue, tReadFile;
     SDL_Window *window = NULL;
     SDL_Renderer *renderer = NULL;
+    RunOptions options;
+
+    if (!parseOptions(argc, argv, &options))
+        return -1;
 
     printf("🚦 Traffic Junction Simulator Starting...\n");
 
-    init_queue(&laneA1);
-    init_queue(&laneA2);
-    init_queue(&laneA3);
-    init_queue(&laneB1);
-    init_queue(&laneB2);
-    init_queue(&laneB3);
-    init_queue(&laneC1);
-    init_queue(&laneC2);
-    init_queue(&laneC3);
-    init_queue(&laneD1);
-    init_queue(&laneD2);
-    init_queue(&laneD3);
+    junction_init(&junction, NULL);
+    junction.sched.verbose = true;
+    junction.on_departure = logDeparture;
+    junction.on_schedule = traceScheduler;
 
-    initializePriorityQueue();
+    if (options.tracePath)
+    {
+        if (!trace_init(options.tracePath))
+            return -1;
+        trace_install_dump_signal(SIGUSR1);
+        trace_thread_name("render");
+        printf("🧵 Tracing spans; dump with kill -USR1 %d or the T key\n", (int)getpid());
+    }
+
+    if (!ingest_init(&ingestHub, options.shards))
+        return -1;
 
-    if (!initializeSDL(&window, &renderer))
+    if (!initializeSDL(&window, &renderer, options.headless))
     {
         fprintf(stderr, "SDL initialization failed\n");
+        ingest_free(&ingestHub);
         return -1;
     }
 
-    SharedData sharedData = {0, 0, SDL_CreateMutex(), 0.0f, 0, 0, 0, 0.0f, 0};
+    SharedData sharedData = {0, SDL_CreateMutex(), 0.0f, 0.0f, 0};
     if (!sharedData.mutex)
     {
         fprintf(stderr, "Failed to create mutex: %s\n", SDL_GetError());
@@ -124,46 +237,30 @@ int main()
         return -1;
     }
 
-    pthread_create(&tQueue, NULL, processQueues, &sharedData);
-    pthread_create(&tReadFile, NULL, readAndParseFile, &sharedData);
+    RenderCache cache;
+    initializeRenderCache(renderer, font, &cache);
+    stateChangedEvent = SDL_RegisterEvents(1);
 
-    bool running = true;
-    float lastTime = SDL_GetTicks() / 1000.0f;
-    printf("✅ Simulator initialized. Waiting for vehicles...\n");
+    telemetry = telemetry_create(options.telemetryName);
+    if (telemetry)
+        printf("📡 Publishing telemetry at /dev/shm%s\n", options.telemetryName);
+    publishTelemetry(0.0f);
 
-    while (running)
-    {
-        SDL_Event event;
-        while (SDL_PollEvent(&event))
-        {
-            if (event.type == SDL_QUIT)
-                running = false;
-        }
-
-        float currentTime = SDL_GetTicks() / 1000.0f;
-        float deltaTime = currentTime - lastTime;
-        lastTime = currentTime;
-
-        SDL_LockMutex(sharedData.mutex);
-
-        // Update light transition animation
-        if (sharedData.currentLight != 0)
-            sharedData.lightTransition = fmin(sharedData.lightTransition + deltaTime * 2.0f, 1.0f);
-        else
-            sharedData.lightTransition = fmax(sharedData.lightTransition - deltaTime * 2.0f, 0.0f);
-
-        render(renderer, font, largeFont, smallFont, &sharedData);
-        SDL_UnlockMutex(sharedData.mutex);
-
-        SDL_Delay(33); // ~30 FPS
-    }
-
-    pthread_cancel(tQueue);
-    pthread_cancel(tReadFile);
-    pthread_join(tQueue, NULL);
-    pthread_join(tReadFile, NULL);
+    int status;
+    if (options.recordPath)
+        status = runRecording(renderer, font, largeFont, smallFont, &sharedData, &cache, &options);
+    else
+        status = runInteractive(renderer, font, largeFont, smallFont, &sharedData, &cache);
 
+    if (options.tracePath)
+        trace_dump();
+    telemetry_destroy(telemetry, options.telemetryName);
+    ingest_free(&ingestHub);
     SDL_DestroyMutex(sharedData.mutex);
+    if (cache.scene)
+        SDL_DestroyTexture(cache.scene);
+    if (cache.background)
+        SDL_DestroyTexture(cache.background);
     TTF_CloseFont(font);
     TTF_CloseFont(largeFont);
     TTF_CloseFont(smallFont);
@@ -171,150 +268,384 @@ int main()
     SDL_DestroyWindow(window);
     TTF_Quit();
     SDL_Quit();
-    return 0;
+    return status;
 }
 
-bool initializeSDL(SDL_Window **window, SDL_Renderer **renderer)
+static void printUsage(const char *program)
 {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0)
-    {
-        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
-        return false;
-    }
+    printf("Usage: %s [options]\n", program);
+    printf("  --record PATH   Render offscreen and export frames (.y4m video, %%06d.png sequence, or raw RGBA)\n");
+    printf("  --fps N         Frames per simulated second when recording (default %d)\n", DEFAULT_RECORD_FPS);
+    printf("  --speed X       Recording pace as a multiple of real time, 0 = as fast as possible (default 0)\n");
+    printf("  --duration S    Simulated seconds to record, 0 = until closed or interrupted (default 0)\n");
+    printf("  --workers N     Encoder threads for --record (default %d)\n", DEFAULT_CAPTURE_WORKERS);
+    printf("  --headless      Use a hidden window and the software renderer\n");
+    printf("  --trace PATH    Record lock, parse, scheduler and frame spans; dumped as Chrome trace JSON\n");
+    printf("                  on SIGUSR1, on the T key and at exit\n");
+    printf("  --shards N      Read N input files (%s, %s.1, ...) with one parser thread each (default 1)\n",
+           VEHICLE_BASE_FILE, VEHICLE_BASE_FILE);
+    printf("  --telemetry NAME  Shared-memory segment for telemetry_reader -n (default %s)\n", TELEMETRY_NAME);
+}
 
-    if (TTF_Init() < 0)
+bool parseOptions(int argc, char *argv[], RunOptions *options)
+{
+    static const struct option longOptions[] = {
+        {"record", required_argument, NULL, 'r'},
+        {"fps", required_argument, NULL, 'f'},
+        {"speed", required_argument, NULL, 's'},
+        {"duration", required_argument, NULL, 'd'},
+        {"workers", required_argument, NULL, 'w'},
+        {"headless", no_argument, NULL, 'x'},
+        {"shards", required_argument, NULL, 'n'},
+        {"trace", required_argument, NULL, 'T'},
+        {"telemetry", required_argument, NULL, 'm'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}};
+
+    *options = (RunOptions){NULL, DEFAULT_RECORD_FPS, 0.0f, 0.0f, DEFAULT_CAPTURE_WORKERS, false, 1, NULL, TELEMETRY_NAME};
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", longOptions, NULL)) != -1)
     {
-        fprintf(stderr, "TTF_Init failed: %s\n", TTF_GetError());
-        SDL_Quit();
-        return false;
+        switch (opt)
+        {
+        case 'r':
+            options->recordPath = optarg;
+            break;
+        case 'f':
+            options->fps = atoi(optarg);
+            break;
+        case 's':
+            options->speed = atof(optarg);
+            break;
+        case 'd':
+            options->duration = atof(optarg);
+            break;
+        case 'w':
+            options->workers = atoi(optarg);
+            break;
+        case 'x':
+            options->headless = true;
+            break;
+        case 'n':
+            options->shards = atoi(optarg);
+            break;
+        case 'T':
+            options->tracePath = optarg;
+            break;
+        case 'm':
+            options->telemetryName = optarg;
+            break;
+        case 'h':
+            printUsage(argv[0]);
+            exit(0);
+        default:
+            printUsage(argv[0]);
+            return false;
+        }
     }
 
-    *window = SDL_CreateWindow("Traffic Junction Simulator",
-                               SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                               WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN);
-    if (!*window)
+    if (options->fps < 1 || options->fps > 240 || options->speed < 0.0f ||
+        options->duration < 0.0f || options->workers < 1 || options->workers > 64 ||
+        options->shards < 1 || options->shards > MAX_SHARDS)
     {
-        fprintf(stderr, "Failed to create window: %s\n", SDL_GetError());
-        TTF_Quit();
-        SDL_Quit();
+        fprintf(stderr, "Invalid --fps, --speed, --duration, --workers or --shards value\n");
         return false;
     }
-
-    *renderer = SDL_CreateRenderer(*window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-    if (!*renderer)
+    if (options->telemetryName[0] != '/' || strchr(options->telemetryName + 1, '/'))
     {
-        fprintf(stderr, "Failed to create renderer: %s\n", SDL_GetError());
-        SDL_DestroyWindow(*window);
-        TTF_Quit();
-        SDL_Quit();
+        fprintf(stderr, "--telemetry needs a name of the form /name\n");
         return false;
     }
     return true;
 }
 
-void initializePriorityQueue()
+// Live mode: the queue thread and one parser per shard advance the simulation
+// on the wall clock while this loop repaints whenever they report a change
+int runInteractive(SDL_Renderer *renderer, TTF_Font *font, TTF_Font *largeFont, TTF_Font *smallFont,
+                   SharedData *sharedData, RenderCache *cache)
 {
-    priorityQueue[0] = (PriorityQueueItem){&laneA1, 0, 0, 1};
-    priorityQueue[1] = (PriorityQueueItem){&laneA2, 1, 0, 2}; // AL2 starts with priority 1
-    priorityQueue[2] = (PriorityQueueItem){&laneA3, 0, 0, 3};
-    priorityQueue[3] = (PriorityQueueItem){&laneB1, 0, 1, 1};
-    priorityQueue[4] = (PriorityQueueItem){&laneB2, 0, 1, 2};
-    priorityQueue[5] = (PriorityQueueItem){&laneB3, 0, 1, 3};
-    priorityQueue[6] = (PriorityQueueItem){&laneC1, 0, 2, 1};
-    priorityQueue[7] = (PriorityQueueItem){&laneC2, 0, 2, 2};
-    priorityQueue[8] = (PriorityQueueItem){&laneC3, 0, 2, 3};
-    priorityQueue[9] = (PriorityQueueItem){&laneD1, 0, 3, 1};
-    priorityQueue[10] = (PriorityQueueItem){&laneD2, 0, 3, 2};
-    priorityQueue[11] = (PriorityQueueItem){&laneD3, 0, 3, 3};
-}
+    pthread_t tQueue, tParsers[MAX_SHARDS];
+    sem_init(&arrivalsReady, 0, 0);
+    pthread_create(&tQueue, NULL, processQueues, sharedData);
+    for (int k = 0; k < ingestHub.numShards; k++)
+        pthread_create(&tParsers[k], NULL, shardParser, &ingestHub.shards[k]);
 
-void updatePriorityQueue(SharedData *sharedData)
-{
-    int al2_count = get_count(&laneA2);
+    bool running = true;
+    bool frameDue = true; // Set whenever something may need repainting
+    Uint32 nextFrame = SDL_GetTicks();
+    float lastTime = SDL_GetTicks() / 1000.0f;
+    int mouseX = WINDOW_WIDTH / 2, mouseY = WINDOW_HEIGHT / 2;
+    printf("✅ Simulator initialized. Waiting for vehicles...\n");
+    printf("🔍 Mouse wheel or +/- zooms, drag pans, 0 resets the view\n");
 
-    // High Priority Mode Logic (from assignment spec)
-    if (al2_count > HIGH_PRIORITY_THRESHOLD) // >10 vehicles
+    while (running)
     {
-        if (!sharedData->high_priority_mode)
+        // Sleep until a state change arrives or, while animating, the next frame is due
+        SDL_Event event;
+        int gotEvent;
+        if (cache->animating || frameDue)
         {
-            printf("🔴 HIGH PRIORITY MODE ACTIVATED - AL2 has %d vehicles\n", al2_count);
+            Sint32 wait = (Sint32)(nextFrame - SDL_GetTicks());
+            gotEvent = SDL_WaitEventTimeout(&event, wait > 0 ? wait : 0);
         }
-        sharedData->high_priority_mode = 1;
-        sharedData->priority_cooldown = PRIORITY_COOLDOWN;
-    }
-    else if (al2_count < NORMAL_PRIORITY_THRESHOLD) // <5 vehicles
-    {
-        if (sharedData->high_priority_mode)
+        else
         {
-            printf("🟢 HIGH PRIORITY MODE DEACTIVATED - AL2 has %d vehicles\n", al2_count);
+            gotEvent = SDL_WaitEvent(&event);
         }
-        sharedData->high_priority_mode = 0;
-        sharedData->priority_cooldown = 0;
-    }
 
-    // Update priorities
-    for (int i = 0; i < 12; i++)
-    {
-        int count = get_count(priorityQueue[i].queue);
-        if (priorityQueue[i].queue == &laneA2 && sharedData->high_priority_mode)
+        bool cameraChanged = false;
+        while (gotEvent)
         {
-            priorityQueue[i].priority = 1000; // Highest priority
+            if (event.type == SDL_QUIT)
+                running = false;
+            else if (event.type == stateChangedEvent)
+            {
+                atomic_store(&wakePending, false);
+                frameDue = true;
+            }
+            else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_EXPOSED)
+            {
+                cache->needsPresent = true;
+                frameDue = true;
+            }
+            else if (event.type == SDL_RENDER_TARGETS_RESET)
+            {
+                refreshBackground(renderer, font, cache); // Texture contents were lost
+                frameDue = true;
+            }
+            else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_t)
+            {
+                trace_dump();
+            }
+            else if (event.type == SDL_MOUSEWHEEL && event.wheel.y != 0)
+            {
+                zoomCamera(&cache->camera, event.wheel.y > 0 ? ZOOM_STEP : 1.0f / ZOOM_STEP, mouseX, mouseY);
+                cameraChanged = true;
+            }
+            else if (event.type == SDL_MOUSEMOTION)
+            {
+                mouseX = event.motion.x;
+                mouseY = event.motion.y;
+                if (event.motion.state & SDL_BUTTON_LMASK)
+                {
+                    panCamera(&cache->camera, event.motion.xrel, event.motion.yrel);
+                    cameraChanged = true;
+                }
+            }
+            else if (event.type == SDL_KEYDOWN)
+            {
+                SDL_Keycode key = event.key.keysym.sym;
+                if (key == SDLK_EQUALS || key == SDLK_PLUS)
+                    zoomCamera(&cache->camera, ZOOM_STEP, WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2);
+                else if (key == SDLK_MINUS)
+                    zoomCamera(&cache->camera, 1.0f / ZOOM_STEP, WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2);
+                else if (key == SDLK_0)
+                    resetCamera(&cache->camera);
+                cameraChanged = cameraChanged || key == SDLK_EQUALS || key == SDLK_PLUS || key == SDLK_MINUS || key == SDLK_0;
+            }
+            gotEvent = SDL_PollEvent(&event);
         }
-        else
+
+        // A whole drag's worth of motion events costs one background redraw
+        if (cameraChanged)
         {
-            priorityQueue[i].priority = count; // Normal priority based on queue length
+            refreshBackground(renderer, font, cache);
+            frameDue = true;
         }
+
+        // Ignore unrelated input, and cap redraws at ~30 FPS when changes arrive faster
+        if ((!cache->animating && !frameDue) || (Sint32)(SDL_GetTicks() - nextFrame) < 0)
+            continue;
+
+        float currentTime = SDL_GetTicks() / 1000.0f;
+        float deltaTime = fminf(currentTime - lastTime, FRAME_MS / 1000.0f * 2); // No jump after idling
+        lastTime = currentTime;
+
+        lockShared(sharedData, "render");
+        uint64_t frameStart = TRACE_NOW();
+        updateLightTransition(sharedData, deltaTime);
+        render(renderer, font, largeFont, smallFont, sharedData, cache);
+        trace_span("frame render", NULL, frameStart, TRACE_NOW());
+        unlockShared(sharedData);
+
+        frameDue = false;
+        nextFrame = SDL_GetTicks() + FRAME_MS;
     }
-}
 
-int findMostCongestedLane(SharedData *sharedData)
-{
-    int maxCount = 0;
-    for (int i = 0; i < 12; i++)
+    pthread_cancel(tQueue);
+    pthread_join(tQueue, NULL);
+    for (int k = 0; k < ingestHub.numShards; k++)
     {
-        if (i != 1) // Skip AL2 in normal congestion check
-        {
-            int count = get_count(priorityQueue[i].queue);
-            if (count > maxCount)
-                maxCount = count;
-        }
+        pthread_cancel(tParsers[k]);
+        pthread_join(tParsers[k], NULL);
     }
-    return maxCount;
+    sem_destroy(&arrivalsReady);
+    return 0;
+}
+
+static void handleStopSignal(int sig)
+{
+    (void)sig;
+    stopRequested = 1;
 }
 
-void checkEmergencyOverflow(SharedData *sharedData)
+// Copies the finished scene into a capture buffer. Streaming textures cannot be
+// read back in SDL2, so the pixels come from the scene render target.
+static bool captureFrame(SDL_Renderer *renderer, RenderCache *cache, Capture *capture)
 {
-    for (int i = 0; i < 12; i++)
+    uint8_t *pixels = capture_acquire(capture); // Waits only if every encoder buffer is busy
+
+    SDL_SetRenderTarget(renderer, cache->scene);
+    int result = SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_RGBA32, pixels, WINDOW_WIDTH * 4);
+    SDL_SetRenderTarget(renderer, NULL);
+
+    if (result != 0)
     {
-        int count = get_count(priorityQueue[i].queue);
-        if (count > EMERGENCY_THRESHOLD)
-        {
-            printf("🚨 EMERGENCY OVERFLOW: Lane %d has %d vehicles\n", i + 1, count);
-            sharedData->emergency_override = 1;
-            sharedData->currentLight = i + 1;
-            return;
-        }
+        fprintf(stderr, "Failed to read back frame: %s\n", SDL_GetError());
+        memset(pixels, 0, (size_t)WINDOW_WIDTH * WINDOW_HEIGHT * 4);
     }
-    sharedData->emergency_override = 0;
+    capture_submit(capture, pixels);
+    return result == 0;
 }
 
-int getHighestPriorityLane()
+// Record mode: the simulation runs on this thread against a virtual clock that
+// advances exactly 1/fps per frame, so the output does not depend on how fast
+// frames can be rendered or encoded
+int runRecording(SDL_Renderer *renderer, TTF_Font *font, TTF_Font *largeFont, TTF_Font *smallFont,
+                 SharedData *sharedData, RenderCache *cache, const RunOptions *options)
 {
-    int maxPriority = -1;
-    int selectedLane = 0;
+    if (!cache->scene)
+    {
+        fprintf(stderr, "Recording needs render-target support from the renderer\n");
+        return -1;
+    }
 
-    for (int i = 0; i < 12; i++)
+    Capture *capture = capture_open(options->recordPath, WINDOW_WIDTH, WINDOW_HEIGHT, options->fps, options->workers);
+    if (!capture)
+        return -1;
+
+    signal(SIGINT, handleStopSignal); // Ctrl-C finishes the file instead of truncating it
+    signal(SIGTERM, handleStopSignal);
+
+    SimulationClock clock;
+    initSimulationClock(&clock, 0.0f);
+    float frameTime = 1.0f / options->fps;
+    float nextRead = 0.0f;
+    Uint32 startTicks = SDL_GetTicks();
+    bool running = true;
+    long frame;
+
+    printf("🎥 Recording to %s at %d FPS (%s)\n", options->recordPath, options->fps,
+           options->speed > 0.0f ? "paced" : "as fast as possible");
+
+    for (frame = 0; running && !stopRequested; frame++)
     {
-        if (!is_empty(priorityQueue[i].queue))
+        float simTime = frame * frameTime;
+        if (options->duration > 0.0f && simTime >= options->duration)
+            break;
+
+        SDL_Event event;
+        while (SDL_PollEvent(&event))
+        {
+            if (event.type == SDL_QUIT)
+                running = false;
+            else if (event.type == stateChangedEvent)
+                atomic_store(&wakePending, false);
+        }
+
+        // Parse every shard on this thread, once per simulated second
+        if (simTime >= nextRead)
         {
-            if (priorityQueue[i].priority > maxPriority)
+            for (int k = 0; k < ingestHub.numShards; k++)
             {
-                maxPriority = priorityQueue[i].priority;
-                selectedLane = i + 1;
+                uint64_t parseStart = TRACE_NOW();
+                ingest_parse_shard(&ingestHub.shards[k], ingest_now_ms());
+                trace_span("parse batch", ingestHub.shards[k].path, parseStart, TRACE_NOW());
             }
+            nextRead += 1.0f;
         }
+
+        lockShared(sharedData, "record");
+        drainShards(simTime);
+        advanceSimulation(&clock, simTime);
+        uint64_t frameStart = TRACE_NOW();
+        updateLightTransition(sharedData, frameTime);
+        cache->needsPresent = true; // Every frame is captured, changed or not
+        render(renderer, font, largeFont, smallFont, sharedData, cache);
+        trace_span("frame render", NULL, frameStart, TRACE_NOW());
+        unlockShared(sharedData);
+
+        uint64_t captureStart = TRACE_NOW();
+        if (!captureFrame(renderer, cache, capture))
+            running = false;
+        trace_span("capture readback", NULL, captureStart, TRACE_NOW());
+
+        if (options->speed > 0.0f)
+        {
+            Uint32 due = startTicks + (Uint32)((frame + 1) * frameTime * 1000.0f / options->speed);
+            Sint32 wait = (Sint32)(due - SDL_GetTicks());
+            if (wait > 0)
+                SDL_Delay(wait);
+        }
+    }
+
+    long written = capture_close(capture);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    if (written < 0)
+    {
+        fprintf(stderr, "Recording to %s failed\n", options->recordPath);
+        return -1;
+    }
+
+    printf("🎬 Wrote %ld frames (%.1fs simulated) in %.1fs\n",
+           written, frame * frameTime, (SDL_GetTicks() - startTicks) / 1000.0f);
+    return 0;
+}
+
+bool initializeSDL(SDL_Window **window, SDL_Renderer **renderer, bool headless)
+{
+    // The dummy driver needs no display server; must be chosen before SDL_Init
+    if (headless)
+        setenv("SDL_VIDEODRIVER", "dummy", 1);
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    if (TTF_Init() < 0)
+    {
+        fprintf(stderr, "TTF_Init failed: %s\n", TTF_GetError());
+        SDL_Quit();
+        return false;
+    }
+
+    *window = SDL_CreateWindow("Traffic Junction Simulator",
+                               SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                               WINDOW_WIDTH, WINDOW_HEIGHT, headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN);
+    if (!*window)
+    {
+        fprintf(stderr, "Failed to create window: %s\n", SDL_GetError());
+        TTF_Quit();
+        SDL_Quit();
+        return false;
     }
-    return selectedLane;
+
+    Uint32 flags = headless ? SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE
+                            : SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE;
+    *renderer = SDL_CreateRenderer(*window, -1, flags);
+    if (!*renderer)
+    {
+        fprintf(stderr, "Failed to create renderer: %s\n", SDL_GetError());
+        SDL_DestroyWindow(*window);
+        TTF_Quit();
+        SDL_Quit();
+        return false;
+    }
+    return true;
 }
 
 SDL_Color getLaneColor(char road, int lane)
@@ -361,46 +692,129 @@ void displayText(SDL_Renderer *renderer, TTF_Font *font, const char *text, int x
     SDL_DestroyTexture(texture);
 }
 
-void drawIntersection(SDL_Renderer *renderer, TTF_Font *font)
+void resetCamera(Camera *camera)
 {
+    *camera = (Camera){0.0f, 0.0f, 1.0f};
+}
+
+// Zooms by `factor` while keeping the world point under the given screen pixel in place
+void zoomCamera(Camera *camera, float factor, int screenX, int screenY)
+{
+    float zoom = fminf(fmaxf(camera->zoom * factor, MIN_ZOOM), MAX_ZOOM);
+    float worldX = camera->x + screenX / camera->zoom;
+    float worldY = camera->y + screenY / camera->zoom;
+    camera->zoom = zoom;
+    camera->x = worldX - screenX / zoom;
+    camera->y = worldY - screenY / zoom;
+    panCamera(camera, 0, 0); // Re-apply the pan limits
+}
+
+// Drags the view by a screen-space offset, keeping the window centre within
+// WORLD_MARGIN of the original layout
+void panCamera(Camera *camera, int dx, int dy)
+{
+    float halfW = WINDOW_WIDTH / 2 / camera->zoom, halfH = WINDOW_HEIGHT / 2 / camera->zoom;
+    float centerX = camera->x - dx / camera->zoom + halfW;
+    float centerY = camera->y - dy / camera->zoom + halfH;
+    centerX = fminf(fmaxf(centerX, -WORLD_MARGIN), WINDOW_WIDTH + WORLD_MARGIN);
+    centerY = fminf(fmaxf(centerY, -WORLD_MARGIN), WINDOW_HEIGHT + WORLD_MARGIN);
+    camera->x = centerX - halfW;
+    camera->y = centerY - halfH;
+}
+
+// World rectangle to the screen pixels it covers
+static SDL_Rect worldToScreen(const Camera *camera, float x, float y, float w, float h)
+{
+    int x0 = (int)floorf((x - camera->x) * camera->zoom);
+    int y0 = (int)floorf((y - camera->y) * camera->zoom);
+    int x1 = (int)ceilf((x + w - camera->x) * camera->zoom);
+    int y1 = (int)ceilf((y + h - camera->y) * camera->zoom);
+    return (SDL_Rect){x0, y0, x1 - x0, y1 - y0};
+}
+
+// Part of a world rectangle that is inside the window; empty if none
+static SDL_Rect worldToWindow(const Camera *camera, float x, float y, float w, float h)
+{
+    SDL_Rect window = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+    SDL_Rect screen = worldToScreen(camera, x, y, w, h), visible;
+    if (!SDL_IntersectRect(&screen, &window, &visible))
+        return (SDL_Rect){0, 0, 0, 0};
+    return visible;
+}
+
+void drawIntersection(SDL_Renderer *renderer, TTF_Font *font, const Camera *camera)
+{
+    // World area in view; the roads run on to its edges
+    float left = camera->x, top = camera->y;
+    float right = left + WINDOW_WIDTH / camera->zoom, bottom = top + WINDOW_HEIGHT / camera->zoom;
+
     // Background gradient
     SDL_SetRenderDrawColor(renderer, 40, 45, 60, 255);
     SDL_RenderClear(renderer);
 
     // Draw roads
     SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255);
-    SDL_Rect hRoad = {0, WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2, WINDOW_WIDTH, ROAD_WIDTH};
-    SDL_Rect vRoad = {WINDOW_WIDTH / 2 - ROAD_WIDTH / 2, 0, ROAD_WIDTH, WINDOW_HEIGHT};
+    SDL_Rect hRoad = worldToWindow(camera, left, WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2, right - left, ROAD_WIDTH);
+    SDL_Rect vRoad = worldToWindow(camera, WINDOW_WIDTH / 2 - ROAD_WIDTH / 2, top, ROAD_WIDTH, bottom - top);
     SDL_RenderFillRect(renderer, &hRoad);
     SDL_RenderFillRect(renderer, &vRoad);
 
     // Draw intersection
     SDL_SetRenderDrawColor(renderer, 70, 70, 70, 255);
-    SDL_Rect center = {WINDOW_WIDTH / 2 - ROAD_WIDTH / 2, WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2, ROAD_WIDTH, ROAD_WIDTH};
+    SDL_Rect center = worldToScreen(camera, WINDOW_WIDTH / 2 - ROAD_WIDTH / 2, WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2, ROAD_WIDTH, ROAD_WIDTH);
     SDL_RenderFillRect(renderer, &center);
 
-    // Draw lane dividers
+    // Draw lane dividers, dashed until the dashes would blur into a line
     SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
+    bool dashed = 40 * camera->zoom >= 6.0f;
+    float junctionLeft = WINDOW_WIDTH / 2 - ROAD_WIDTH / 2, junctionRight = WINDOW_WIDTH / 2 + ROAD_WIDTH / 2;
+    float junctionTop = WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2, junctionBottom = WINDOW_HEIGHT / 2 + ROAD_WIDTH / 2;
     for (int i = 1; i <= 2; i++) // Only 2 dividers for 3 lanes
     {
         // Horizontal road dividers
-        int y = WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 + LANE_WIDTH * i;
-        for (int x = 0; x < WINDOW_WIDTH; x += 40)
+        int y = worldToScreen(camera, 0, junctionTop + LANE_WIDTH * i, 0, 0).y;
+        if (dashed)
         {
-            if (x < WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 || x > WINDOW_WIDTH / 2 + ROAD_WIDTH / 2)
-                SDL_RenderDrawLine(renderer, x, y, x + 20, y);
+            for (float x = floorf(left / 40) * 40; x < right; x += 40)
+            {
+                if (x < junctionLeft || x > junctionRight)
+                {
+                    SDL_Rect dash = worldToScreen(camera, x, 0, 20, 0);
+                    SDL_RenderDrawLine(renderer, dash.x, y, dash.x + dash.w, y);
+                }
+            }
+        }
+        else
+        {
+            SDL_Rect west = worldToScreen(camera, left, 0, junctionLeft - left, 0);
+            SDL_Rect east = worldToScreen(camera, junctionRight, 0, right - junctionRight, 0);
+            SDL_RenderDrawLine(renderer, west.x, y, west.x + west.w, y);
+            SDL_RenderDrawLine(renderer, east.x, y, east.x + east.w, y);
         }
 
         // Vertical road dividers
-        int x = WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 + LANE_WIDTH * i;
-        for (int y2 = 0; y2 < WINDOW_HEIGHT; y2 += 40)
+        int x = worldToScreen(camera, junctionLeft + LANE_WIDTH * i, 0, 0, 0).x;
+        if (dashed)
+        {
+            for (float y2 = floorf(top / 40) * 40; y2 < bottom; y2 += 40)
+            {
+                if (y2 < junctionTop || y2 > junctionBottom)
+                {
+                    SDL_Rect dash = worldToScreen(camera, 0, y2, 0, 20);
+                    SDL_RenderDrawLine(renderer, x, dash.y, x, dash.y + dash.h);
+                }
+            }
+        }
+        else
         {
-            if (y2 < WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 || y2 > WINDOW_HEIGHT / 2 + ROAD_WIDTH / 2)
-                SDL_RenderDrawLine(renderer, x, y2, x, y2 + 20);
+            SDL_Rect north = worldToScreen(camera, 0, top, 0, junctionTop - top);
+            SDL_Rect south = worldToScreen(camera, 0, junctionBottom, 0, bottom - junctionBottom);
+            SDL_RenderDrawLine(renderer, x, north.y, x, north.y + north.h);
+            SDL_RenderDrawLine(renderer, x, south.y, x, south.y + south.h);
         }
     }
 
-    // Draw directional labels
+    // Draw directional labels at the window edges, whatever the view
     SDL_Color white = {220, 220, 220, 255};
     displayText(renderer, font, "NORTH", WINDOW_WIDTH / 2 - 25, 10, white, true);
     displayText(renderer, font, "SOUTH", WINDOW_WIDTH / 2 - 25, WINDOW_HEIGHT - 30, white, true);
@@ -408,16 +822,17 @@ void drawIntersection(SDL_Renderer *renderer, TTF_Font *font)
     displayText(renderer, font, "WEST", 10, WINDOW_HEIGHT / 2 - 15, white, true);
 }
 
-void drawTrafficLight(SDL_Renderer *renderer, bool isGreen, float transition, int x, int y, int road, int lane, TTF_Font *smallFont)
+// x/y is the light's top-left corner on screen
+void drawTrafficLight(SDL_Renderer *renderer, bool isGreen, float transition, int x, int y, int radius, int road, int lane, TTF_Font *smallFont, bool showLabel)
 {
     // Shadow
     SDL_SetRenderDrawColor(renderer, 20, 20, 20, 100);
-    SDL_Rect shadow = {x + 3, y + 3, LIGHT_RADIUS * 2 + 6, LIGHT_RADIUS * 2 + 6};
+    SDL_Rect shadow = {x + 3, y + 3, radius * 2 + 6, radius * 2 + 6};
     SDL_RenderFillRect(renderer, &shadow);
 
     // Light background
     SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
-    SDL_Rect bg = {x, y, LIGHT_RADIUS * 2, LIGHT_RADIUS * 2};
+    SDL_Rect bg = {x, y, radius * 2, radius * 2};
     SDL_RenderFillRect(renderer, &bg);
 
     // Light color with smooth transition
@@ -427,104 +842,211 @@ void drawTrafficLight(SDL_Renderer *renderer, bool isGreen, float transition, in
 
     SDL_SetRenderDrawColor(renderer, r, g, b, 255);
 
-    // Draw circular light
-    for (int i = 0; i < LIGHT_RADIUS * 2; i++)
+    // Draw circular light, one span per row
+    int inner = radius > 2 ? radius - 2 : 1;
+    for (int j = 0; j < radius * 2; j++)
     {
-        for (int j = 0; j < LIGHT_RADIUS * 2; j++)
-        {
-            int dx = i - LIGHT_RADIUS;
-            int dy = j - LIGHT_RADIUS;
-            if (dx * dx + dy * dy <= (LIGHT_RADIUS - 2) * (LIGHT_RADIUS - 2))
-                SDL_RenderDrawPoint(renderer, x + i, y + j);
-        }
+        int dy = j - radius;
+        if (dy * dy > inner * inner)
+            continue;
+        int dx = (int)sqrtf((float)(inner * inner - dy * dy));
+        SDL_RenderDrawLine(renderer, x + radius - dx, y + j, x + radius + dx, y + j);
     }
 
+    if (!showLabel)
+        return;
+
     // Lane label
     char roadNames[] = {'A', 'B', 'C', 'D'};
     char laneText[5];
     snprintf(laneText, sizeof(laneText), "%cL%d", roadNames[road], lane);
     SDL_Color white = {220, 220, 220, 255};
-    displayText(renderer, smallFont, laneText, x - 5, y + LIGHT_RADIUS * 2 + 5, white, true);
+    displayText(renderer, smallFont, laneText, x - 5, y + radius * 2 + 5, white, true);
 }
 
-void drawVehicle(SDL_Renderer *renderer, int x, int y, char road, int lane, const char *plate, TTF_Font *smallFont, float offset)
+// body is the vehicle's rectangle on screen. Undetailed vehicles are a plain
+// box, for zoom levels where the plate would be unreadable.
+void drawVehicle(SDL_Renderer *renderer, SDL_Rect body, char road, int lane, VehicleClass vehicleClass, const char *plate, TTF_Font *smallFont, bool detailed)
 {
     SDL_Color color = getLaneColor(road, lane);
+    if (vehicleClass == VEHICLE_BUS)
+        color = (SDL_Color){255, 200, 0, 255};
+    else if (vehicleClass == VEHICLE_EMERGENCY)
+        color = (SDL_Color){245, 245, 245, 255};
+
+    if (!detailed)
+    {
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRect(renderer, &body);
+        return;
+    }
 
     // Shadow
     SDL_SetRenderDrawColor(renderer, 20, 20, 20, 100);
-    SDL_Rect shadow = {x + 2, y + 2, VEHICLE_WIDTH, VEHICLE_HEIGHT};
+    SDL_Rect shadow = {body.x + 2, body.y + 2, body.w, body.h};
     SDL_RenderFillRect(renderer, &shadow);
 
-    // Vehicle body with movement offset
+    // Vehicle body
     SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    SDL_Rect vehicle = {
-        x + (int)(offset * (road == 'C' || road == 'D' ? VEHICLE_WIDTH + VEHICLE_SPACING : 0)),
-        y + (int)(offset * (road == 'A' || road == 'B' ? VEHICLE_HEIGHT + VEHICLE_SPACING : 0)),
-        VEHICLE_WIDTH, VEHICLE_HEIGHT};
-    SDL_RenderFillRect(renderer, &vehicle);
+    SDL_RenderFillRect(renderer, &body);
 
     // Windshield
     SDL_SetRenderDrawColor(renderer, 180, 180, 220, 255);
-    SDL_Rect windshield = {vehicle.x + 5, vehicle.y + 2, VEHICLE_WIDTH - 10, VEHICLE_HEIGHT / 3};
+    SDL_Rect windshield = {body.x + body.w / 8, body.y + body.h / 10, body.w - body.w / 4, body.h / 3};
     SDL_RenderFillRect(renderer, &windshield);
 
+    // Light bar
+    if (vehicleClass == VEHICLE_EMERGENCY)
+    {
+        SDL_SetRenderDrawColor(renderer, 220, 0, 0, 255);
+        SDL_Rect lightBar = {body.x + body.w / 20, body.y + body.h - body.h / 4, body.w - body.w / 10, body.h / 7 + 1};
+        SDL_RenderFillRect(renderer, &lightBar);
+    }
+
     // License plate (first 3 chars)
     if (strlen(plate) >= 3)
     {
         char shortPlate[4] = {0};
         strncpy(shortPlate, plate, 3);
         SDL_Color black = {0, 0, 0, 255};
-        displayText(renderer, smallFont, shortPlate, vehicle.x + 5, vehicle.y + VEHICLE_HEIGHT / 2 - 3, black, false);
+        displayText(renderer, smallFont, shortPlate, body.x + body.w / 8, body.y + body.h / 2 - 3, black, false);
     }
 }
 
-void drawQueue(SDL_Renderer *renderer, Queue *queue, int startX, int startY, char road, int lane, TTF_Font *font, float offset, SharedData *sharedData)
+// Green through yellow to red as a queue approaches the overflow threshold
+static SDL_Color queueHeatColor(int count)
 {
-    int count = get_count(queue);
-    int selectedLane = (sharedData->currentLight - 1);
-    bool isGreen = (sharedData->currentLight != 0 && selectedLane >= 0 && selectedLane < 12 &&
-                    priorityQueue[selectedLane].road == (road - 'A') && priorityQueue[selectedLane].lane == lane);
+    float t = fminf((float)count / EMERGENCY_THRESHOLD, 1.0f);
+    return (SDL_Color){(Uint8)(255 * fminf(2.0f * t, 1.0f)), (Uint8)(255 * fminf(2.0f - 2.0f * t, 1.0f)), 40, 255};
+}
 
-    for (int i = 0; i < count && i < MAX_VISIBLE_VEHICLES; i++)
+// Zoomed far out: the whole queue as one bar from its last vehicle to its
+// first, colored by length, with a marker if an emergency vehicle is waiting
+static void drawQueueBar(SDL_Renderer *renderer, Queue *queue, LaneDynamics *dynamics, int count,
+                         int stopX, int stopY, char road, const Camera *camera)
+{
+    float front = dynamics->pos[0], back = dynamics->pos[count - 1];
+    SDL_Rect bar;
+    switch (road)
     {
-        int x = startX, y = startY;
+    case 'A':
+        bar = worldToScreen(camera, stopX, stopY + back * PIXELS_PER_METER_V, VEHICLE_WIDTH, (front - back) * PIXELS_PER_METER_V + VEHICLE_HEIGHT);
+        break;
+    case 'B':
+        bar = worldToScreen(camera, stopX, stopY - front * PIXELS_PER_METER_V, VEHICLE_WIDTH, (front - back) * PIXELS_PER_METER_V + VEHICLE_HEIGHT);
+        break;
+    case 'C':
+        bar = worldToScreen(camera, stopX - front * PIXELS_PER_METER_H, stopY, (front - back) * PIXELS_PER_METER_H + VEHICLE_WIDTH, VEHICLE_HEIGHT);
+        break;
+    default:
+        bar = worldToScreen(camera, stopX + back * PIXELS_PER_METER_H, stopY, (front - back) * PIXELS_PER_METER_H + VEHICLE_WIDTH, VEHICLE_HEIGHT);
+        break;
+    }
+    if (bar.w < 2)
+        bar.w = 2;
+    if (bar.h < 2)
+        bar.h = 2;
 
-        // Base position based on road direction
-        if (road == 'A' || road == 'B') // Vertical roads
-        {
-            y += i * (VEHICLE_HEIGHT + VEHICLE_SPACING);
-            if (isGreen)
-            {
-                // First vehicle moves to center, others follow proportionally
-                float moveDistance = (i == 0) ? offset * (road == 'A' ? (WINDOW_HEIGHT / 2 - y - VEHICLE_HEIGHT) : -(y - (WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2)))
-                                              : offset * (VEHICLE_HEIGHT + VEHICLE_SPACING) * 0.8f; // Slower follow for realism
-                y += (int)moveDistance;
-            }
-        }
-        else // Horizontal roads (C, D)
-        {
-            x += i * (VEHICLE_WIDTH + VEHICLE_SPACING);
-            if (isGreen)
-            {
-                float moveDistance = (i == 0) ? offset * (road == 'D' ? (WINDOW_WIDTH / 2 - x - VEHICLE_WIDTH) : -(x - (WINDOW_WIDTH / 2 - ROAD_WIDTH / 2)))
-                                              : offset * (VEHICLE_WIDTH + VEHICLE_SPACING) * 0.8f;
-                x += (int)moveDistance;
-            }
-        }
+    SDL_Color heat = queueHeatColor(count);
+    SDL_SetRenderDrawColor(renderer, heat.r, heat.g, heat.b, heat.a);
+    SDL_RenderFillRect(renderer, &bar);
 
-        // Skip drawing first vehicle if it's close to the center (about to be dequeued)
-        if (isGreen && i == 0 && offset > 0.95f) // Hide when near center
-            continue;
+    if (get_class_count(queue, VEHICLE_EMERGENCY) > 0)
+    {
+        SDL_SetRenderDrawColor(renderer, 245, 245, 245, 255);
+        SDL_Rect marker = {bar.x + bar.w / 2 - 3, bar.y + bar.h / 2 - 3, 6, 6};
+        SDL_RenderFillRect(renderer, &marker);
+    }
+}
+
+// First vehicle whose stop-line position is at most `pos`. Positions fall
+// from the front of the queue to the back, so this is a binary search.
+static int firstVehicleBehind(const LaneDynamics *dynamics, int count, float pos)
+{
+    int lo = 0, hi = count;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (dynamics->pos[mid] > pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
 
-        char plate[9] = "XXX";
-        if (i < queue->count)
+// stopX/stopY is where a vehicle sits in the world when its front bumper is
+// on the stop line. Only the vehicles inside `region` (screen pixels) are
+// visited, so the cost follows what is on screen rather than queue length.
+void drawQueue(SDL_Renderer *renderer, Queue *queue, LaneDynamics *dynamics, int stopX, int stopY, char road, int lane, TTF_Font *font,
+               const SDL_Rect *region, const Camera *camera)
+{
+    int count = dynamics->count < get_count(queue) ? dynamics->count : get_count(queue);
+    if (count == 0)
+        return;
+
+    if (camera->zoom < LOD_BAR_ZOOM)
+    {
+        drawQueueBar(renderer, queue, dynamics, count, stopX, stopY, road, camera);
+        return;
+    }
+
+    // The region in world pixels, widened by the 2px shadow
+    float shadow = 2.0f / camera->zoom;
+    float left = camera->x + region->x / camera->zoom - shadow, right = camera->x + (region->x + region->w) / camera->zoom;
+    float top = camera->y + region->y / camera->zoom - shadow, bottom = camera->y + (region->y + region->h) / camera->zoom;
+
+    // Stop-line positions (m) of the vehicles that can overlap it
+    float nearest, farthest;
+    switch (road)
+    {
+    case 'A': // Heading south
+        nearest = (bottom - stopY) / PIXELS_PER_METER_V;
+        farthest = (top - VEHICLE_HEIGHT - stopY) / PIXELS_PER_METER_V;
+        break;
+    case 'B': // Heading north
+        nearest = (stopY + VEHICLE_HEIGHT - top) / PIXELS_PER_METER_V;
+        farthest = (stopY - bottom) / PIXELS_PER_METER_V;
+        break;
+    case 'C': // Heading west
+        nearest = (stopX + VEHICLE_WIDTH - left) / PIXELS_PER_METER_H;
+        farthest = (stopX - right) / PIXELS_PER_METER_H;
+        break;
+    default: // D, heading east
+        nearest = (right - stopX) / PIXELS_PER_METER_H;
+        farthest = (left - VEHICLE_WIDTH - stopX) / PIXELS_PER_METER_H;
+        break;
+    }
+
+    bool detailed = camera->zoom >= LOD_DETAIL_ZOOM;
+    for (int i = firstVehicleBehind(dynamics, count, nearest); i < count && dynamics->pos[i] >= farthest; i++)
+    {
+        float pos = dynamics->pos[i];
+        float x = stopX, y = stopY;
+
+        switch (road)
         {
-            memcpy(plate, queue->items[(queue->front + i) % MAX_QUEUE_SIZE].vehicle_id, 8);
-            plate[8] = '\0';
+        case 'A':
+            y += pos * PIXELS_PER_METER_V;
+            break;
+        case 'B':
+            y -= pos * PIXELS_PER_METER_V;
+            break;
+        case 'C':
+            x -= pos * PIXELS_PER_METER_H;
+            break;
+        default:
+            x += pos * PIXELS_PER_METER_H;
+            break;
         }
 
-        drawVehicle(renderer, x, y, road, lane, plate, font, 0.0f);
+        const Vehicle *vehicle = &queue->items[(queue->front + i) % MAX_QUEUE_SIZE];
+        char plate[9];
+        memcpy(plate, vehicle->vehicle_id, 8);
+        plate[8] = '\0';
+
+        drawVehicle(renderer, worldToScreen(camera, x, y, VEHICLE_WIDTH, VEHICLE_HEIGHT), road, lane,
+                    vehicle->vehicle_class, plate, font, detailed);
     }
 }
 
@@ -546,249 +1068,527 @@ void drawCurrentStatus(SDL_Renderer *renderer, TTF_Font *largeFont, int currentL
     displayText(renderer, largeFont, buffer, WINDOW_WIDTH / 2 - 150, 30, white, true);
 }
 
-void render(SDL_Renderer *renderer, TTF_Font *font, TTF_Font *largeFont, TTF_Font *smallFont, SharedData *sharedData)
+// Where a lane's vehicles sit in the world when their front bumper is on the stop line
+static void getLaneAnchor(int i, int *stopX, int *stopY)
 {
-    drawIntersection(renderer, font);
+    int lane = junction.priorityQueue[i].lane;
+    int laneX = WINDOW_WIDTH / 2 + (lane - 2) * LANE_WIDTH - VEHICLE_WIDTH / 2;
+    int laneY = WINDOW_HEIGHT / 2 + (lane - 2) * LANE_WIDTH - VEHICLE_HEIGHT / 2;
 
-    // Draw traffic lights for all lanes
-    int lightPositions[12][2] = {
-        // Road A (North)
-        {WINDOW_WIDTH / 2 - LANE_WIDTH - LIGHT_RADIUS, 120}, // AL1
-        {WINDOW_WIDTH / 2 - LIGHT_RADIUS, 120},              // AL2
-        {WINDOW_WIDTH / 2 + LANE_WIDTH - LIGHT_RADIUS, 120}, // AL3
-        // Road B (South)
-        {WINDOW_WIDTH / 2 - LANE_WIDTH - LIGHT_RADIUS, WINDOW_HEIGHT - 140}, // BL1
-        {WINDOW_WIDTH / 2 - LIGHT_RADIUS, WINDOW_HEIGHT - 140},              // BL2
-        {WINDOW_WIDTH / 2 + LANE_WIDTH - LIGHT_RADIUS, WINDOW_HEIGHT - 140}, // BL3
-        // Road C (East)
-        {WINDOW_WIDTH - 140, WINDOW_HEIGHT / 2 - LANE_WIDTH - LIGHT_RADIUS}, // CL1
-        {WINDOW_WIDTH - 140, WINDOW_HEIGHT / 2 - LIGHT_RADIUS},              // CL2
-        {WINDOW_WIDTH - 140, WINDOW_HEIGHT / 2 + LANE_WIDTH - LIGHT_RADIUS}, // CL3
-        // Road D (West)
-        {120, WINDOW_HEIGHT / 2 - LANE_WIDTH - LIGHT_RADIUS}, // DL1
-        {120, WINDOW_HEIGHT / 2 - LIGHT_RADIUS},              // DL2
-        {120, WINDOW_HEIGHT / 2 + LANE_WIDTH - LIGHT_RADIUS}  // DL3
-    };
+    switch (junction.priorityQueue[i].road)
+    {
+    case 0: // A
+        *stopX = laneX;
+        *stopY = WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 - VEHICLE_HEIGHT;
+        break;
+    case 1: // B
+        *stopX = laneX;
+        *stopY = WINDOW_HEIGHT / 2 + ROAD_WIDTH / 2;
+        break;
+    case 2: // C
+        *stopX = WINDOW_WIDTH / 2 + ROAD_WIDTH / 2;
+        *stopY = laneY;
+        break;
+    default: // D
+        *stopX = WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 - VEHICLE_WIDTH;
+        *stopY = laneY;
+        break;
+    }
+}
 
-    for (int i = 0; i < 12; i++)
+// On-screen part of the strip of road a lane's vehicles can occupy, from the
+// edge of the view to the far side of the junction; empty when out of view
+static SDL_Rect getLaneRegion(int i, const Camera *camera)
+{
+    int stopX, stopY;
+    getLaneAnchor(i, &stopX, &stopY);
+
+    // World edges of the view, so the strip reaches however far out the camera looks
+    float left = camera->x, top = camera->y;
+    float right = left + WINDOW_WIDTH / camera->zoom, bottom = top + WINDOW_HEIGHT / camera->zoom;
+    float margin = 2.0f / camera->zoom; // Shadow
+
+    switch (junction.priorityQueue[i].road)
     {
-        bool isGreen = (sharedData->currentLight == i + 1);
-        drawTrafficLight(renderer, isGreen, sharedData->lightTransition,
-                         lightPositions[i][0], lightPositions[i][1],
-                         priorityQueue[i].road, priorityQueue[i].lane, smallFont);
+    case 0:
+        return worldToWindow(camera, stopX, top, VEHICLE_WIDTH + margin, WINDOW_HEIGHT / 2 + ROAD_WIDTH / 2 - top);
+    case 1:
+        return worldToWindow(camera, stopX, WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2, VEHICLE_WIDTH + margin, bottom - (WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2));
+    case 2:
+        return worldToWindow(camera, WINDOW_WIDTH / 2 - ROAD_WIDTH / 2, stopY, right - (WINDOW_WIDTH / 2 - ROAD_WIDTH / 2), VEHICLE_HEIGHT + margin);
+    default:
+        return worldToWindow(camera, left, stopY, WINDOW_WIDTH / 2 + ROAD_WIDTH / 2 - left, VEHICLE_HEIGHT + margin);
     }
+}
 
-    // Vehicle movement offset for animation
-    float offset = (sharedData->currentLight != 0) ? fmod(SDL_GetTicks() / 1000.0f, TIME_PER_VEHICLE) / TIME_PER_VEHICLE : 0.0f;
+// Light housing, shadow and lane label on screen
+static SDL_Rect getLightRegion(int i, const Camera *camera, int *radius)
+{
+    SDL_Rect light = worldToScreen(camera, lightPositions[i][0], lightPositions[i][1], LIGHT_RADIUS * 2, LIGHT_RADIUS * 2);
+    *radius = light.w / 2 > 2 ? light.w / 2 : 2;
+    return (SDL_Rect){light.x - 6, light.y - 2, *radius * 2 + 16, *radius * 2 + 26};
+}
 
-    // Draw vehicle queues
-    drawQueue(renderer, &laneA1, WINDOW_WIDTH / 2 - LANE_WIDTH - VEHICLE_WIDTH / 2, 160, 'A', 1, smallFont, offset, sharedData);
-    drawQueue(renderer, &laneA2, WINDOW_WIDTH / 2 - VEHICLE_WIDTH / 2, 160, 'A', 2, smallFont, offset, sharedData);
-    drawQueue(renderer, &laneA3, WINDOW_WIDTH / 2 + LANE_WIDTH - VEHICLE_WIDTH / 2, 160, 'A', 3, smallFont, offset, sharedData);
+static SDL_Rect getStatusRegion(void)
+{
+    return (SDL_Rect){WINDOW_WIDTH / 2 - 150, 30, 420, 48};
+}
 
-    drawQueue(renderer, &laneB1, WINDOW_WIDTH / 2 - LANE_WIDTH - VEHICLE_WIDTH / 2, WINDOW_HEIGHT - 240, 'B', 1, smallFont, offset, sharedData);
-    drawQueue(renderer, &laneB2, WINDOW_WIDTH / 2 - VEHICLE_WIDTH / 2, WINDOW_HEIGHT - 240, 'B', 2, smallFont, offset, sharedData);
-    drawQueue(renderer, &laneB3, WINDOW_WIDTH / 2 + LANE_WIDTH - VEHICLE_WIDTH / 2, WINDOW_HEIGHT - 240, 'B', 3, smallFont, offset, sharedData);
+bool initializeRenderCache(SDL_Renderer *renderer, TTF_Font *font, RenderCache *cache)
+{
+    memset(cache, 0, sizeof(*cache));
+    resetCamera(&cache->camera);
+    cache->fullRedraw = true;
 
-    drawQueue(renderer, &laneC1, WINDOW_WIDTH - 240, WINDOW_HEIGHT / 2 - LANE_WIDTH - VEHICLE_HEIGHT / 2, 'C', 1, smallFont, offset, sharedData);
-    drawQueue(renderer, &laneC2, WINDOW_WIDTH - 240, WINDOW_HEIGHT / 2 - VEHICLE_HEIGHT / 2, 'C', 2, smallFont, offset, sharedData);
-    drawQueue(renderer, &laneC3, WINDOW_WIDTH - 240, WINDOW_HEIGHT / 2 + LANE_WIDTH - VEHICLE_HEIGHT / 2, 'C', 3, smallFont, offset, sharedData);
+    // Without render targets every change falls back to a full-frame redraw
+    if (!SDL_RenderTargetSupported(renderer))
+        return false;
 
-    drawQueue(renderer, &laneD1, 160, WINDOW_HEIGHT / 2 - LANE_WIDTH - VEHICLE_HEIGHT / 2, 'D', 1, smallFont, offset, sharedData);
-    drawQueue(renderer, &laneD2, 160, WINDOW_HEIGHT / 2 - VEHICLE_HEIGHT / 2, 'D', 2, smallFont, offset, sharedData);
-    drawQueue(renderer, &laneD3, 160, WINDOW_HEIGHT / 2 + LANE_WIDTH - VEHICLE_HEIGHT / 2, 'D', 3, smallFont, offset, sharedData);
+    cache->background = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT);
+    cache->scene = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT);
+    if (!cache->background || !cache->scene)
+    {
+        fprintf(stderr, "Render targets unavailable, redrawing full frames: %s\n", SDL_GetError());
+        if (cache->background)
+            SDL_DestroyTexture(cache->background);
+        if (cache->scene)
+            SDL_DestroyTexture(cache->scene);
+        cache->background = cache->scene = NULL;
+        return false;
+    }
 
-    drawCurrentStatus(renderer, largeFont, sharedData->currentLight);
-    SDL_RenderPresent(renderer);
+    refreshBackground(renderer, font, cache);
+    return true;
 }
 
-void *processQueues(void *arg)
+void refreshBackground(SDL_Renderer *renderer, TTF_Font *font, RenderCache *cache)
 {
-    SharedData *sharedData = (SharedData *)arg;
-    int status_counter = 0;
-    float lastProcessTime = SDL_GetTicks() / 1000.0f;
+    cache->fullRedraw = true;
+    if (!cache->background)
+        return;
 
-    printf("🔧 Queue processing thread started\n");
+    SDL_SetRenderTarget(renderer, cache->background);
+    drawIntersection(renderer, font, &cache->camera);
+    SDL_SetRenderTarget(renderer, NULL);
+}
 
-    while (1)
-    {
-        float currentTime = SDL_GetTicks() / 1000.0f;
+void notifyStateChanged(void)
+{
+    // One pending wake-up is enough; the renderer re-reads all state anyway
+    if (atomic_exchange(&wakePending, true))
+        return;
 
-        SDL_LockMutex(sharedData->mutex);
+    SDL_Event event;
+    memset(&event, 0, sizeof(event));
+    event.type = stateChangedEvent;
+    SDL_PushEvent(&event);
+}
 
-        // Print status every 5 seconds
-        if (status_counter++ % 25 == 0)
-        {
-            printQueueStatus(sharedData);
-        }
+// Compares the shared state against what is on screen and returns the regions to redraw
+static int collectDirtyRegions(SharedData *sharedData, RenderCache *cache, SDL_Rect *dirty)
+{
+    int n = 0;
+    int currentLight = junction.sched.currentLight;
+    bool transitionChanged = sharedData->lightTransition != cache->lastTransition;
+
+    cache->animating = (currentLight != 0 && sharedData->lightTransition < 1.0f) ||
+                       (currentLight == 0 && sharedData->lightTransition > 0.0f);
 
-        // Update priority and check emergency conditions
-        updatePriorityQueue(sharedData);
-        checkEmergencyOverflow(sharedData);
+    // After a camera move the background is redrawn and every region goes stale
+    if (cache->fullRedraw)
+        dirty[n++] = (SDL_Rect){0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
 
-        // Process vehicles based on timing
-        if (currentTime - lastProcessTime >= TIME_PER_VEHICLE)
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        int radius;
+        bool wasGreen = (cache->lastLight == i + 1), isGreen = (currentLight == i + 1);
+        if (!cache->fullRedraw && (transitionChanged || wasGreen != isGreen))
+            dirty[n++] = getLightRegion(i, &cache->camera, &radius);
+
+        // Moving lanes stay dirty for one extra frame so vehicles are drawn where they stopped
+        bool moving = lane_is_moving(&junction.dynamics[i]);
+        if (!cache->fullRedraw && (moving || cache->laneMoving[i] ||
+                                   junction.lanes[i].front != cache->laneFront[i] || junction.lanes[i].count != cache->laneCount[i]))
         {
-            if (sharedData->high_priority_mode && !sharedData->emergency_override)
-            {
-                // HIGH PRIORITY MODE: Serve AL2 first
-                if (!is_empty(&laneA2))
-                {
-                    sharedData->currentLight = 2; // AL2
-                    Vehicle v = dequeue(&laneA2);
-                    printf("🔴 [PRIORITY] Dequeued: %s from AL2 (count now: %d)\n",
-                           v.vehicle_id, get_count(&laneA2));
-                    lastProcessTime = currentTime;
-                }
-                else
-                {
-                    sharedData->currentLight = 0; // No vehicles in priority lane
-                }
-            }
-            else
-            {
-                // NORMAL MODE: Serve highest priority lane
-                int selectedLane = getHighestPriorityLane();
-                if (selectedLane > 0)
-                {
-                    sharedData->currentLight = selectedLane;
-                    Queue *laneToServe = priorityQueue[selectedLane - 1].queue;
-
-                    if (!is_empty(laneToServe))
-                    {
-                        Vehicle v = dequeue(laneToServe);
-                        printf("🟢 [NORMAL] Dequeued: %s from %cL%d (count now: %d)\n",
-                               v.vehicle_id,
-                               'A' + priorityQueue[selectedLane - 1].road,
-                               priorityQueue[selectedLane - 1].lane,
-                               get_count(laneToServe));
-                        lastProcessTime = currentTime;
-                    }
-                }
-                else
-                {
-                    sharedData->currentLight = 0; // No vehicles in any lane
-                }
-            }
+            SDL_Rect laneRegion = getLaneRegion(i, &cache->camera);
+            if (laneRegion.w > 0) // Empty when the lane is out of view
+                dirty[n++] = laneRegion;
         }
 
-        SDL_UnlockMutex(sharedData->mutex);
-        usleep(200000); // Check every 200ms
+        cache->laneMoving[i] = moving;
+        cache->laneFront[i] = junction.lanes[i].front;
+        cache->laneCount[i] = junction.lanes[i].count;
+        cache->animating = cache->animating || moving;
     }
-    return NULL;
+
+    if (!cache->fullRedraw && currentLight != cache->lastLight)
+        dirty[n++] = getStatusRegion();
+
+    cache->lastLight = currentLight;
+    cache->lastTransition = sharedData->lightTransition;
+    cache->fullRedraw = false;
+    return n;
+}
+
+// Repaints everything that overlaps the region, clipped to it
+static void drawRegion(SDL_Renderer *renderer, TTF_Font *font, TTF_Font *largeFont, TTF_Font *smallFont,
+                       SharedData *sharedData, RenderCache *cache, const SDL_Rect *region)
+{
+    SDL_RenderSetClipRect(renderer, region);
+
+    const Camera *camera = &cache->camera;
+    if (cache->background)
+        SDL_RenderCopy(renderer, cache->background, region, region);
+    else
+        drawIntersection(renderer, font, camera);
+
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        int radius;
+        SDL_Rect light = getLightRegion(i, camera, &radius);
+        if (!SDL_HasIntersection(&light, region))
+            continue;
+
+        bool isGreen = (junction.sched.currentLight == i + 1);
+        drawTrafficLight(renderer, isGreen, sharedData->lightTransition, light.x + 6, light.y + 2, radius,
+                         junction.priorityQueue[i].road, junction.priorityQueue[i].lane, smallFont, camera->zoom >= LOD_DETAIL_ZOOM);
+    }
+
+    // Draw vehicle queues at their simulated positions; lanes out of view cost nothing
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        SDL_Rect laneRegion = getLaneRegion(i, camera);
+        if (!SDL_HasIntersection(&laneRegion, region))
+            continue;
+
+        int stopX, stopY;
+        getLaneAnchor(i, &stopX, &stopY);
+        drawQueue(renderer, &junction.lanes[i], &junction.dynamics[i], stopX, stopY,
+                  'A' + junction.priorityQueue[i].road, junction.priorityQueue[i].lane, smallFont, region, camera);
+    }
+
+    SDL_Rect status = getStatusRegion();
+    if (SDL_HasIntersection(&status, region))
+        drawCurrentStatus(renderer, largeFont, junction.sched.currentLight);
+
+    SDL_RenderSetClipRect(renderer, NULL);
+}
+
+void render(SDL_Renderer *renderer, TTF_Font *font, TTF_Font *largeFont, TTF_Font *smallFont, SharedData *sharedData, RenderCache *cache)
+{
+    SDL_Rect dirty[MAX_DIRTY_REGIONS];
+    int numDirty = collectDirtyRegions(sharedData, cache, dirty);
+    if (numDirty == 0 && !cache->needsPresent)
+        return; // Nothing changed: skip the redraw and the present
+
+    if (cache->scene)
+    {
+        SDL_SetRenderTarget(renderer, cache->scene);
+        for (int i = 0; i < numDirty; i++)
+            drawRegion(renderer, font, largeFont, smallFont, sharedData, cache, &dirty[i]);
+        SDL_SetRenderTarget(renderer, NULL);
+        SDL_RenderCopy(renderer, cache->scene, NULL, NULL);
+    }
+    else
+    {
+        // The back buffer is undefined after a present, so repaint all of it
+        SDL_Rect window = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+        drawRegion(renderer, font, largeFont, smallFont, sharedData, cache, &window);
+    }
+
+    cache->needsPresent = false;
+    SDL_RenderPresent(renderer);
+}
+
+// Junction departure hook: logs each vehicle that drives clear of the junction
+void logDeparture(void *user, int lane, const Vehicle *vehicle, double now)
+{
+    (void)user;
+    (void)now;
+    if (vehicle->vehicle_class == VEHICLE_EMERGENCY)
+        printf("🚑 [EMERGENCY] Dequeued: %s from %cL%d (count now: %d)\n",
+               vehicle->vehicle_id,
+               'A' + junction.priorityQueue[lane].road,
+               junction.priorityQueue[lane].lane,
+               get_count(&junction.lanes[lane]));
+    else if (lane == 1 && junction.sched.high_priority_mode)
+        printf("🔴 [PRIORITY] Dequeued: %s from AL2 (count now: %d)\n",
+               vehicle->vehicle_id, get_count(&junction.lanes[lane]));
+    else
+        printf("🟢 [NORMAL] Dequeued: %s from %cL%d (count now: %d)\n",
+               vehicle->vehicle_id,
+               'A' + junction.priorityQueue[lane].road,
+               junction.priorityQueue[lane].lane,
+               get_count(&junction.lanes[lane]));
+}
+
+// Junction schedule hook: records each scheduler run as its own span inside
+// the enclosing "junction step"
+void traceScheduler(void *user, bool done)
+{
+    static _Thread_local uint64_t start;
+    (void)user;
+    if (!done)
+        start = TRACE_NOW();
+    else
+        trace_span("scheduler tick", NULL, start, TRACE_NOW());
+}
+
+void initSimulationClock(SimulationClock *clock, float now)
+{
+    clock->lastStatusTime = now - STATUS_INTERVAL; // Report on the first call
+    clock->lastStepTime = now;
+}
+
+// Brings the junction up to simulation time `now` in whole ticks. Caller
+// holds the mutex. Returns true if a light changed or a vehicle left.
+bool advanceSimulation(SimulationClock *clock, float now)
+{
+    int previousLight = junction.sched.currentLight;
+    unsigned long previousGreens = junction.emergency_greens;
+    unsigned long served[NUM_LANES];
+    memcpy(served, junction.lane_served, sizeof(served));
+
+    if (now - clock->lastStatusTime >= STATUS_INTERVAL)
+    {
+        clock->lastStatusTime = now;
+        printQueueStatus();
+    }
+
+    int ticks = 0;
+    while (clock->lastStepTime + JUNCTION_TICK_SECONDS <= now)
+    {
+        clock->lastStepTime += JUNCTION_TICK_SECONDS;
+        ticks++;
+    }
+    uint64_t stepStart = TRACE_NOW();
+    int discharged = junction_step(&junction, ticks);
+    trace_span("junction step", NULL, stepStart, TRACE_NOW());
+
+    int light = junction.sched.currentLight;
+    if (junction.emergency_greens != previousGreens && light > 0)
+        printf("🚑 %cL%d green %.2fs after its emergency vehicle arrived\n",
+               'A' + junction.priorityQueue[light - 1].road, junction.priorityQueue[light - 1].lane,
+               junction.emergency_latency_last);
+
+    // Lanes that shrank have room for more of the shards' records
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        if (junction.lane_served[i] != served[i])
+            ingest_set_lane_free(&ingestHub, i, MAX_QUEUE_SIZE - get_count(&junction.lanes[i]));
+    }
+
+    bool changed = discharged > 0 || junction.sched.currentLight != previousLight;
+    if (changed)
+        publishTelemetry(now);
+    return changed;
+}
+
+// Copies the monitored state into shared memory. Caller holds the mutex,
+// which also makes this the segment's only writer.
+void publishTelemetry(float now)
+{
+    if (!telemetry)
+        return;
+
+    TelemetrySnapshot snapshot;
+    snapshot.updates = telemetry->snapshot.updates + 1;
+    snapshot.sim_time = now;
+    snapshot.current_light = junction.sched.currentLight;
+    snapshot.high_priority_mode = junction.sched.high_priority_mode;
+    snapshot.emergency_override = junction.sched.emergency_override;
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        snapshot.lane_count[i] = get_count(&junction.lanes[i]);
+        snapshot.lane_served[i] = junction.lane_served[i];
+    }
+    snapshot.total_arrived = junction.total_arrived;
+    snapshot.total_served = junction.total_served;
+    snapshot.emergency_lanes = junction.sched.emergency_mask;
+    snapshot.preempted_lane = junction.sched.preempted_lane;
+    snapshot.emergency_greens = junction.emergency_greens;
+    snapshot.emergency_latency_avg = junction.emergency_greens ? junction.emergency_latency_total / junction.emergency_greens : 0.0;
+    snapshot.emergency_latency_max = junction.emergency_latency_max;
+    telemetry_publish(telemetry, &snapshot);
+}
+
+// SharedData.mutex wrappers that trace how long each site waited for the
+// lock and then held it
+void lockShared(SharedData *sharedData, const char *site)
+{
+    uint64_t start = TRACE_NOW();
+    SDL_LockMutex(sharedData->mutex);
+    lockAcquiredAt = TRACE_NOW();
+    lockSite = site;
+    trace_span("lock wait", site, start, lockAcquiredAt);
+}
+
+void unlockShared(SharedData *sharedData)
+{
+    uint64_t end = TRACE_NOW();
+    SDL_UnlockMutex(sharedData->mutex);
+    trace_span("lock hold", lockSite, lockAcquiredAt, end);
 }
 
-void *readAndParseFile(void *arg)
+void updateLightTransition(SharedData *sharedData, float deltaTime)
+{
+    if (junction.sched.currentLight != 0)
+        sharedData->lightTransition = fmin(sharedData->lightTransition + deltaTime * 2.0f, 1.0f);
+    else
+        sharedData->lightTransition = fmax(sharedData->lightTransition - deltaTime * 2.0f, 0.0f);
+}
+
+void *processQueues(void *arg)
 {
     SharedData *sharedData = (SharedData *)arg;
-    printf("📁 File reading thread started\n");
+    SimulationClock clock;
+    initSimulationClock(&clock, SDL_GetTicks() / 1000.0f);
 
+    trace_thread_name("scheduler");
+    printf("🔧 Queue processing thread started\n");
+
+    bool idle = false;
     while (1)
     {
-        FILE *file = fopen(VEHICLE_FILE, "r");
-        if (!file)
+        float currentTime = SDL_GetTicks() / 1000.0f;
+
+        lockShared(sharedData, "scheduler");
+        // After sleeping through an idle spell, catch the clock up before
+        // arrivals are stamped with it
+        bool changed = idle && advanceSimulation(&clock, currentTime);
+        uint64_t mergeStart = TRACE_NOW();
+        int added = drainShards(currentTime);
+        trace_span("merge shards", NULL, mergeStart, TRACE_NOW());
+
+        // Moving vehicles keep the renderer animating on its own; it only
+        // needs waking when vehicles arrive or leave or the light changes
+        if (advanceSimulation(&clock, currentTime) || changed || added > 0)
+            notifyStateChanged();
+
+        idle = !ingest_pending(&ingestHub);
+        for (int i = 0; i < NUM_LANES && idle; i++)
+            idle = get_count(&junction.lanes[i]) == 0;
+        unlockShared(sharedData);
+
+        if (!idle)
         {
-            // Don't spam error messages if file doesn't exist yet
-            usleep(1000000); // Wait 1 second before trying again
+            usleep(50000); // Physics tick every 50ms
             continue;
         }
 
-        SDL_LockMutex(sharedData->mutex);
-
-        char line[100];
-        int vehicles_added = 0;
-
-        while (fgets(line, sizeof(line), file))
+        // Nothing can change until a parser takes vehicles, so sleep until
+        // one does; the timeout keeps the status report coming
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += IDLE_WAIT_MS / 1000;
+        deadline.tv_nsec += (IDLE_WAIT_MS % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
         {
-            // Remove newline
-            line[strcspn(line, "\n")] = 0;
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        sem_timedwait(&arrivalsReady, &deadline);
+        while (sem_trywait(&arrivalsReady) == 0)
+            ; // One wake-up covers every post since
+    }
+    return NULL;
+}
 
-            // Skip empty lines
-            if (strlen(line) == 0)
-                continue;
+// Feeds every lane from the shards' rings, oldest record first, as far as the
+// queue has room. Each vehicle's arrival is backdated by the age of its record,
+// so waits and preemption latency include the time spent being picked up and
+// merged. Caller holds the mutex. Returns the number of vehicles added.
+int drainShards(float now)
+{
+    ShardRecord records[MAX_QUEUE_SIZE];
+    Vehicle batch[MAX_QUEUE_SIZE];
+    int vehicles_added = 0;
+    uint64_t nowMs = ingest_now_ms();
 
-            // Parse: VehicleID:Road:Lane
-            char *vehicleNumber = strtok(line, ":");
-            char *road = strtok(NULL, ":");
-            char *laneStr = strtok(NULL, ":");
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        int n = ingest_merge_lane(&ingestHub, i, MAX_QUEUE_SIZE - get_count(&junction.lanes[i]), records);
+        if (n == 0)
+            continue;
 
-            if (vehicleNumber && road && laneStr)
-            {
-                Vehicle v;
-                strncpy(v.vehicle_id, vehicleNumber, sizeof(v.vehicle_id) - 1);
-                v.vehicle_id[sizeof(v.vehicle_id) - 1] = '\0';
-                v.road = *road;
-                v.lane = atoi(laneStr);
-
-                // Find target queue
-                Queue *target = NULL;
-                switch (*road)
-                {
-                case 'A':
-                    target = (v.lane == 1) ? &laneA1 : (v.lane == 2) ? &laneA2
-                                                                     : &laneA3;
-                    break;
-                case 'B':
-                    target = (v.lane == 1) ? &laneB1 : (v.lane == 2) ? &laneB2
-                                                                     : &laneB3;
-                    break;
-                case 'C':
-                    target = (v.lane == 1) ? &laneC1 : (v.lane == 2) ? &laneC2
-                                                                     : &laneC3;
-                    break;
-                case 'D':
-                    target = (v.lane == 1) ? &laneD1 : (v.lane == 2) ? &laneD2
-                                                                     : &laneD3;
-                    break;
-                }
+        for (int k = 0; k < n; k++)
+        {
+            double age = records[k].timestamp < nowMs ? (nowMs - records[k].timestamp) / 1000.0 : 0.0;
+            batch[k] = records[k].vehicle;
+            batch[k].arrival_time = junction.time - (age < junction.time ? age : junction.time);
+        }
+        vehicles_added += junction_push_arrivals(&junction, batch, n);
 
-                if (target && !is_full(target))
-                {
-                    enqueue(target, v);
-                    vehicles_added++;
-                    printf("➕ Added vehicle %s to %cL%d\n", v.vehicle_id, v.road, v.lane);
-                }
-                else if (target && is_full(target))
-                {
-                    printf("⚠️  Lane %cL%d is full, cannot add %s\n", v.road, v.lane, v.vehicle_id);
-                }
-            }
+        for (int k = 0; k < n; k++)
+        {
+            if (batch[k].vehicle_class == VEHICLE_EMERGENCY)
+                printf("🚑 Emergency vehicle %s arrived on %cL%d\n", batch[k].vehicle_id, batch[k].road, batch[k].lane);
+            else
+                printf("➕ Added vehicle %s to %cL%d\n", batch[k].vehicle_id, batch[k].road, batch[k].lane);
         }
+    }
 
-        SDL_UnlockMutex(sharedData->mutex);
-        fclose(file);
+    if (vehicles_added > 0)
+        publishTelemetry(now);
+    return vehicles_added;
+}
+
+// One per input shard: parses outside the simulator's mutex and hands records
+// over through the shard's lock-free rings
+void *shardParser(void *arg)
+{
+    Shard *shard = (Shard *)arg;
+    trace_thread_name(shard->path);
+    printf("📁 Parser thread started for %s\n", shard->path);
 
-        // Only clear the file if we actually processed vehicles
-        // This prevents race conditions
-        if (vehicles_added > 0)
+    while (1)
+    {
+        // Never cancelled while holding the shard file's lock
+        int oldState;
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &oldState);
+        uint64_t parseStart = TRACE_NOW();
+        int taken = ingest_parse_shard(shard, ingest_now_ms());
+        trace_span("parse batch", shard->path, parseStart, TRACE_NOW());
+        pthread_setcancelstate(oldState, NULL);
+
+        if (taken > 0)
         {
-            FILE *temp = fopen(VEHICLE_FILE, "w");
-            if (temp)
-                fclose(temp);
-            printf("📝 Processed %d vehicles, cleared file\n", vehicles_added);
+            printf("📝 Parsed %d vehicles from %s\n", taken, shard->path);
+            sem_post(&arrivalsReady);
         }
-
-        usleep(1000000); // Check file every 1 second
+        usleep(SHARD_POLL_MS * 1000);
     }
     return NULL;
 }
 
-void printQueueStatus(SharedData *sharedData)
+void printQueueStatus(void)
 {
     printf("\n═══════════════════════════════════════\n");
     printf("🚦 TRAFFIC JUNCTION STATUS\n");
     printf("═══════════════════════════════════════\n");
     printf("Road A: AL1=%2d | AL2=%2d | AL3=%2d\n",
-           get_count(&laneA1), get_count(&laneA2), get_count(&laneA3));
+           get_count(&junction.lanes[0]), get_count(&junction.lanes[1]), get_count(&junction.lanes[2]));
     printf("Road B: BL1=%2d | BL2=%2d | BL3=%2d\n",
-           get_count(&laneB1), get_count(&laneB2), get_count(&laneB3));
+           get_count(&junction.lanes[3]), get_count(&junction.lanes[4]), get_count(&junction.lanes[5]));
     printf("Road C: CL1=%2d | CL2=%2d | CL3=%2d\n",
-           get_count(&laneC1), get_count(&laneC2), get_count(&laneC3));
+           get_count(&junction.lanes[6]), get_count(&junction.lanes[7]), get_count(&junction.lanes[8]));
     printf("Road D: DL1=%2d | DL2=%2d | DL3=%2d\n",
-           get_count(&laneD1), get_count(&laneD2), get_count(&laneD3));
+           get_count(&junction.lanes[9]), get_count(&junction.lanes[10]), get_count(&junction.lanes[11]));
     printf("───────────────────────────────────────\n");
     printf("Priority Mode: %s | Current Light: %d\n",
-           sharedData->high_priority_mode ? "🔴 HIGH" : "🟢 NORMAL",
-           sharedData->currentLight);
+           junction.sched.high_priority_mode ? "🔴 HIGH" : "🟢 NORMAL",
+           junction.sched.currentLight);
+    printf("Arrived: %lu | Served: %lu | Returned (lane full): %lu\n",
+           junction.total_arrived, junction.total_served, ingest_total_returned(&ingestHub));
+    printf("Emergency greens: %lu | Latency avg: %.2fs | max: %.2fs\n",
+           junction.emergency_greens,
+           junction.emergency_greens ? junction.emergency_latency_total / junction.emergency_greens : 0.0,
+           junction.emergency_latency_max);
+    printf("Arrivals/min:");
+    for (int i = 0; i < NUM_LANES; i++)
+        printf("%s%4.1f", i % 3 == 0 ? " | " : " ", arrival_rate(&junction.priorityQueue[i].arrivals, junction.time) * 60.0f);
+    printf("\n");
+    printf("Look-ahead: %d phases, %d plan steps\n",
+           junction.sched.lookahead_depth, junction.sched.lookahead_steps);
     printf("═══════════════════════════════════════\n\n");
 }
\ No newline at end of file
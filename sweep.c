@@ -0,0 +1,463 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "queue.h"
+#include "scheduler.h"
+#include "dynamics.h"
+#include "arrivals.h"
+#include "junction.h"
+
+#define READ_INTERVAL_STEPS 5    // Arrivals are pushed in 250ms batches, as often as the live shard parsers poll
+#define WAIT_BIN_SECONDS 1.0f
+#define WAIT_BINS 3600           // Waits past an hour land in the last bin
+#define MAX_AXIS_VALUES 16
+#define MAX_CONFIGS 4096
+#define DEFAULT_ARRIVAL_RATE (1.0f / 1.5f) // traffic_gen emits a vehicle every 1.5s
+#define SURGE_PERIOD 600.0f // With -u, one road surges for the first SURGE_LENGTH seconds of every period
+#define SURGE_LENGTH 120.0f
+#define NUM_AXES 6
+#define MAX_BATCH 256          // Arrivals handed to the junction per push
+
+typedef struct
+{
+    float values[MAX_AXIS_VALUES];
+    int count;
+} SweepAxis;
+
+typedef struct
+{
+    SchedulerParams params;
+    pthread_mutex_t lock;
+    long runs;
+    long arrivals;
+    long served;
+    long dropped;
+    long queued; // Still waiting when their run ended
+    double waitSum;
+    unsigned int waits[WAIT_BINS];
+    float p50, p90, p99;
+} SweepConfig;
+
+typedef struct
+{
+    SweepConfig *configs;
+    int numConfigs;
+    int replications;
+    float duration;
+    float arrivalRate;
+    float surge; // Arrival multiplier on the surging road, 1 = no surges
+    int lookaheadBudget;
+    uint64_t seed;
+    atomic_long nextJob;
+} SweepPlan;
+
+// splitmix64: tiny, fast and good enough to give every run its own stream
+static uint64_t nextRandom(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double uniform01(uint64_t *state)
+{
+    return (nextRandom(state) >> 11) * 0x1.0p-53;
+}
+
+static double nextInterarrival(uint64_t *rng, float rate)
+{
+    return -log(1.0 - uniform01(rng)) / rate;
+}
+
+typedef struct
+{
+    unsigned int waits[WAIT_BINS];
+    double waitSum;
+} WaitHistogram;
+
+static void addWait(WaitHistogram *histogram, double wait)
+{
+    int bin = (int)(wait / WAIT_BIN_SECONDS);
+    histogram->waits[bin < WAIT_BINS ? bin : WAIT_BINS - 1]++;
+    histogram->waitSum += wait;
+}
+
+static void recordWait(void *user, int lane, const Vehicle *vehicle, double now)
+{
+    (void)lane;
+    addWait((WaitHistogram *)user, now - vehicle->arrival_time);
+}
+
+// Adds one arrival to the pending batch, handing the batch over when it fills
+static void addArrival(Junction *junction, Vehicle *batch, int *n, int lane, double arrival)
+{
+    Vehicle v = {"SWEEP", 'A' + lane / 3, lane % 3 + 1, arrival, VEHICLE_NORMAL};
+    batch[(*n)++] = v;
+    if (*n == MAX_BATCH)
+    {
+        junction_push_arrivals(junction, batch, *n);
+        *n = 0;
+    }
+}
+
+// One GUI-less junction run. Arrivals keep their own times but reach the
+// junction in batches, much as the live simulator's parsers hand them over.
+static void runJunction(const SweepPlan *plan, SweepConfig *config, uint64_t seed, Junction *junction)
+{
+    WaitHistogram histogram = {{0}, 0.0};
+    Vehicle batch[MAX_BATCH];
+    long arrivals = 0;
+    uint64_t rng = seed;
+
+    junction_init(junction, &config->params);
+    junction->on_departure = recordWait;
+    junction->user = &histogram;
+
+    long steps = (long)(plan->duration / DYN_STEP_SECONDS);
+    double nextArrival = nextInterarrival(&rng, plan->arrivalRate);
+
+    // Surges add a second stream on one road, a quarter of the base rate per unit of multiplier
+    float surgeRate = plan->arrivalRate / 4 * (plan->surge - 1.0f);
+    double nextSurge = surgeRate > 0.0f ? nextInterarrival(&rng, surgeRate) : INFINITY;
+
+    for (long step = 0; step < steps; step += READ_INTERVAL_STEPS)
+    {
+        double now = step * (double)DYN_STEP_SECONDS;
+        int n = 0;
+
+        while (nextArrival <= now)
+        {
+            int lane = (int)(nextRandom(&rng) % NUM_LANES);
+            arrivals++;
+            addArrival(junction, batch, &n, lane, nextArrival);
+            nextArrival += nextInterarrival(&rng, plan->arrivalRate);
+        }
+
+        while (nextSurge <= now)
+        {
+            if (fmod(nextSurge, SURGE_PERIOD) < SURGE_LENGTH)
+            {
+                int road = (int)(nextSurge / SURGE_PERIOD) % 4;
+                int lane = road * 3 + (int)(nextRandom(&rng) % 3);
+                arrivals++;
+                addArrival(junction, batch, &n, lane, nextSurge);
+            }
+            nextSurge += nextInterarrival(&rng, surgeRate);
+        }
+        junction_push_arrivals(junction, batch, n);
+
+        // Nothing arrives between reads, so the ticks up to the next one run as one batch
+        long ticks = steps - step < READ_INTERVAL_STEPS ? steps - step : READ_INTERVAL_STEPS;
+        junction_step(junction, (int)ticks);
+    }
+
+    // Vehicles still queued count with their wait so far; leaving them out
+    // would make configurations that starve lanes look best
+    long queued = 0;
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        JunctionLaneView lane = junction_lane_view(junction, i);
+        for (int k = 0; k < lane.count; k++)
+            addWait(&histogram, junction->time - lane.items[(lane.front + k) % MAX_QUEUE_SIZE].arrival_time);
+        queued += lane.count;
+    }
+
+    pthread_mutex_lock(&config->lock);
+    config->runs++;
+    config->arrivals += arrivals;
+    config->served += junction->total_served;
+    config->dropped += junction->total_dropped;
+    config->queued += queued;
+    config->waitSum += histogram.waitSum;
+    for (int i = 0; i < WAIT_BINS; i++)
+        config->waits[i] += histogram.waits[i];
+    pthread_mutex_unlock(&config->lock);
+}
+
+static void *sweepWorker(void *arg)
+{
+    SweepPlan *plan = (SweepPlan *)arg;
+    long totalJobs = (long)plan->numConfigs * plan->replications;
+    Junction *junction = junction_create(NULL);
+    if (!junction)
+        return NULL;
+
+    while (1)
+    {
+        long job = atomic_fetch_add(&plan->nextJob, 1);
+        if (job >= totalJobs)
+            break;
+
+        // Each run's stream starts from splitmix64's mixed output for (base ^ job),
+        // so neighbouring job indices do not get neighbouring states
+        uint64_t state = plan->seed ^ (uint64_t)job;
+        uint64_t seed = nextRandom(&state);
+        runJunction(plan, &plan->configs[job / plan->replications], seed, junction);
+    }
+    junction_destroy(junction);
+    return NULL;
+}
+
+// Over served and still-queued vehicles alike
+static float waitPercentile(const SweepConfig *config, float p)
+{
+    long waited = config->served + config->queued;
+    if (waited == 0)
+        return 0.0f;
+
+    long target = (long)ceil(p * waited);
+    long seen = 0;
+    for (int i = 0; i < WAIT_BINS; i++)
+    {
+        seen += config->waits[i];
+        if (seen >= target)
+            return (i + 1) * WAIT_BIN_SECONDS;
+    }
+    return WAIT_BINS * WAIT_BIN_SECONDS;
+}
+
+static int compareByP90(const void *a, const void *b)
+{
+    const SweepConfig *x = (const SweepConfig *)a;
+    const SweepConfig *y = (const SweepConfig *)b;
+    if (x->p90 != y->p90)
+        return x->p90 < y->p90 ? -1 : 1;
+    return (x->served < y->served) - (x->served > y->served);
+}
+
+static int parseAxis(const char *text, SweepAxis *axis)
+{
+    char buffer[256];
+    strncpy(buffer, text, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    axis->count = 0;
+    for (char *tok = strtok(buffer, ","); tok; tok = strtok(NULL, ","))
+    {
+        if (axis->count == MAX_AXIS_VALUES)
+            return -1;
+        axis->values[axis->count++] = strtof(tok, NULL);
+    }
+    return axis->count > 0 ? 0 : -1;
+}
+
+static float axisMin(const SweepAxis *axis)
+{
+    float m = axis->values[0];
+    for (int i = 1; i < axis->count; i++)
+        m = fminf(m, axis->values[i]);
+    return m;
+}
+
+static float axisMax(const SweepAxis *axis)
+{
+    float m = axis->values[0];
+    for (int i = 1; i < axis->count; i++)
+        m = fmaxf(m, axis->values[i]);
+    return m;
+}
+
+static int addConfig(SweepConfig *configs, int n, SchedulerParams params)
+{
+    // Hysteresis needs the release threshold below the activation threshold
+    if (params.normal_priority_threshold >= params.high_priority_threshold || params.time_per_vehicle <= 0.0f)
+        return n;
+    if (n == MAX_CONFIGS)
+        return n;
+
+    memset(&configs[n], 0, sizeof(SweepConfig));
+    configs[n].params = params;
+    pthread_mutex_init(&configs[n].lock, NULL);
+    return n + 1;
+}
+
+static int buildGrid(SweepConfig *configs, SweepAxis axes[NUM_AXES], int budget)
+{
+    int n = 0;
+    for (int e = 0; e < axes[0].count; e++)
+        for (int h = 0; h < axes[1].count; h++)
+            for (int l = 0; l < axes[2].count; l++)
+                for (int c = 0; c < axes[3].count; c++)
+                    for (int t = 0; t < axes[4].count; t++)
+                        for (int k = 0; k < axes[5].count; k++)
+                        {
+                            SchedulerParams params = {
+                                (int)axes[0].values[e],
+                                (int)axes[1].values[h],
+                                (int)axes[2].values[l],
+                                (int)axes[3].values[c],
+                                axes[4].values[t],
+                                (int)axes[5].values[k],
+                                budget};
+                            n = addConfig(configs, n, params);
+                        }
+    return n;
+}
+
+static int randomInt(uint64_t *rng, const SweepAxis *axis)
+{
+    int lo = (int)axisMin(axis), hi = (int)axisMax(axis);
+    return lo + (int)(nextRandom(rng) % (uint64_t)(hi - lo + 1));
+}
+
+static int buildSample(SweepConfig *configs, SweepAxis axes[NUM_AXES], int samples, uint64_t seed, int budget)
+{
+    int n = 0;
+    uint64_t rng = seed;
+    for (int attempts = 0; n < samples && attempts < samples * 100; attempts++)
+    {
+        float tLo = axisMin(&axes[4]), tHi = axisMax(&axes[4]);
+        SchedulerParams params = {
+            randomInt(&rng, &axes[0]),
+            randomInt(&rng, &axes[1]),
+            randomInt(&rng, &axes[2]),
+            randomInt(&rng, &axes[3]),
+            tLo + (float)uniform01(&rng) * (tHi - tLo),
+            randomInt(&rng, &axes[5]),
+            budget};
+        n = addConfig(configs, n, params);
+    }
+    return n;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -e LIST   EMERGENCY_THRESHOLD values (default 10,15,20)\n"
+            "  -H LIST   HIGH_PRIORITY_THRESHOLD values (default 6,10,14)\n"
+            "  -n LIST   NORMAL_PRIORITY_THRESHOLD values (default 3,5,7)\n"
+            "  -c LIST   PRIORITY_COOLDOWN values (default 10)\n"
+            "  -t LIST   TIME_PER_VEHICLE values in seconds (default 2,3,4,5)\n"
+            "  -l LIST   LOOKAHEAD_PHASES values, 0 = longest queue first (default 0,%d)\n"
+            "  -b N      Look-ahead plan steps per decision (default %d)\n"
+            "  -u X      Every %.0fs one road's arrivals surge to X times its share for %.0fs (default 1, off)\n"
+            "  -s N      Draw N random configurations within each list's range instead of the full grid\n"
+            "  -r N      Replications per configuration (default 20)\n"
+            "  -d SECS   Simulated seconds per run (default 3600)\n"
+            "  -a RATE   Arrivals per second across all lanes (default %.3f)\n"
+            "  -j N      Worker threads (default: all cores)\n"
+            "  -S SEED   Base PRNG seed (default 1)\n",
+            prog, LOOKAHEAD_PHASES, LOOKAHEAD_BUDGET, SURGE_PERIOD, SURGE_LENGTH, DEFAULT_ARRIVAL_RATE);
+}
+
+int main(int argc, char *argv[])
+{
+    SweepAxis axes[NUM_AXES];
+    char defaultLookahead[16];
+    parseAxis("10,15,20", &axes[0]);
+    parseAxis("6,10,14", &axes[1]);
+    parseAxis("3,5,7", &axes[2]);
+    parseAxis("10", &axes[3]);
+    parseAxis("2,3,4,5", &axes[4]);
+    snprintf(defaultLookahead, sizeof(defaultLookahead), "0,%d", LOOKAHEAD_PHASES);
+    parseAxis(defaultLookahead, &axes[5]);
+
+    int samples = 0;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    SweepPlan plan = {NULL, 0, 20, 3600.0f, DEFAULT_ARRIVAL_RATE, 1.0f, LOOKAHEAD_BUDGET, 1, 0};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "e:H:n:c:t:l:b:u:s:r:d:a:j:S:h")) != -1)
+    {
+        int bad = 0;
+        switch (opt)
+        {
+        case 'e': bad = parseAxis(optarg, &axes[0]); break;
+        case 'H': bad = parseAxis(optarg, &axes[1]); break;
+        case 'n': bad = parseAxis(optarg, &axes[2]); break;
+        case 'c': bad = parseAxis(optarg, &axes[3]); break;
+        case 't': bad = parseAxis(optarg, &axes[4]); break;
+        case 'l': bad = parseAxis(optarg, &axes[5]); break;
+        case 'b': plan.lookaheadBudget = atoi(optarg); break;
+        case 'u': plan.surge = strtof(optarg, NULL); break;
+        case 's': samples = atoi(optarg); break;
+        case 'r': plan.replications = atoi(optarg); break;
+        case 'd': plan.duration = strtof(optarg, NULL); break;
+        case 'a': plan.arrivalRate = strtof(optarg, NULL); break;
+        case 'j': threads = atoi(optarg); break;
+        case 'S': plan.seed = strtoull(optarg, NULL, 10); break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+        if (bad)
+        {
+            fprintf(stderr, "Invalid list for -%c (max %d comma-separated values)\n", opt, MAX_AXIS_VALUES);
+            return 1;
+        }
+    }
+
+    if (plan.replications < 1 || plan.duration <= 0.0f || plan.arrivalRate <= 0.0f || threads < 1 ||
+        plan.surge < 1.0f || plan.lookaheadBudget < 1 || axisMin(&axes[5]) < 0.0f)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    plan.configs = calloc(MAX_CONFIGS, sizeof(SweepConfig));
+    if (!plan.configs)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    plan.numConfigs = samples > 0 ? buildSample(plan.configs, axes, samples, plan.seed, plan.lookaheadBudget)
+                                  : buildGrid(plan.configs, axes, plan.lookaheadBudget);
+    if (plan.numConfigs == 0)
+    {
+        fprintf(stderr, "No valid configurations (NORMAL must be below HIGH)\n");
+        free(plan.configs);
+        return 1;
+    }
+
+    fprintf(stderr, "🔬 Sweeping %d configurations x %d runs (%.0fs each) on %d threads...\n",
+            plan.numConfigs, plan.replications, plan.duration, threads);
+
+    pthread_t *workers = malloc(sizeof(pthread_t) * threads);
+    for (int i = 0; i < threads; i++)
+        pthread_create(&workers[i], NULL, sweepWorker, &plan);
+    for (int i = 0; i < threads; i++)
+        pthread_join(workers[i], NULL);
+    free(workers);
+
+    for (int i = 0; i < plan.numConfigs; i++)
+    {
+        SweepConfig *config = &plan.configs[i];
+        config->p50 = waitPercentile(config, 0.50f);
+        config->p90 = waitPercentile(config, 0.90f);
+        config->p99 = waitPercentile(config, 0.99f);
+        pthread_mutex_destroy(&config->lock);
+    }
+    qsort(plan.configs, plan.numConfigs, sizeof(SweepConfig), compareByP90);
+
+    printf("%6s %6s %6s %6s %6s %5s | %9s %7s %7s %8s %8s %8s %8s %8s\n",
+           "EMERG", "HIGH", "NORMAL", "COOL", "TPV", "LOOK", "veh/min", "served%", "backlog", "dropped", "mean", "p50", "p90", "p99");
+    for (int i = 0; i < plan.numConfigs; i++)
+    {
+        const SweepConfig *config = &plan.configs[i];
+        double simMinutes = config->runs * plan.duration / 60.0;
+        long waited = config->served + config->queued;
+        printf("%6d %6d %6d %6d %6.2f %5d | %9.2f %7.1f %7.1f %8ld %8.1f %8.1f %8.1f %8.1f\n",
+               config->params.emergency_threshold,
+               config->params.high_priority_threshold,
+               config->params.normal_priority_threshold,
+               config->params.priority_cooldown,
+               config->params.time_per_vehicle,
+               config->params.lookahead_phases,
+               config->served / simMinutes,
+               config->arrivals ? 100.0 * config->served / config->arrivals : 0.0,
+               (double)config->queued / config->runs,
+               config->dropped,
+               waited ? config->waitSum / waited : 0.0,
+               config->p50, config->p90, config->p99);
+    }
+
+    free(plan.configs);
+    return 0;
+}
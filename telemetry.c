@@ -0,0 +1,173 @@
+#include "telemetry.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static bool process_alive(int32_t pid)
+{
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+// Writer of the segment currently at `name`, 0 if it has none, -1 if there
+// is no valid segment there
+static int32_t named_writer(const char *name)
+{
+    const TelemetrySegment *segment = NULL;
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd >= 0)
+    {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(TelemetrySegment))
+        {
+            void *addr = mmap(NULL, sizeof(TelemetrySegment), PROT_READ, MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED)
+                segment = (const TelemetrySegment *)addr;
+        }
+        close(fd);
+    }
+    if (!segment)
+        return -1;
+
+    int32_t pid = segment->magic == TELEMETRY_MAGIC ? segment->writer_pid : -1;
+    munmap((void *)segment, sizeof(TelemetrySegment));
+    return pid;
+}
+
+// Creates the segment, or takes over one left behind by a simulator that is
+// no longer running, and marks it valid. Refuses a segment whose writer is
+// still alive. Returns NULL on failure; the simulator keeps running without
+// telemetry in that case.
+TelemetrySegment *telemetry_create(const char *name)
+{
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        perror("shm_open");
+        return NULL;
+    }
+
+    // Serialises simulators starting on the same name
+    flock(fd, LOCK_EX);
+    int32_t owner = named_writer(name);
+    if (owner > 0 && owner != (int32_t)getpid() && process_alive(owner))
+    {
+        fprintf(stderr, "Telemetry segment %s is in use by pid %d; pick another with --telemetry\n", name, (int)owner);
+        close(fd);
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(TelemetrySegment)) != 0)
+    {
+        perror("ftruncate");
+        close(fd);
+        return NULL;
+    }
+
+    void *addr = mmap(NULL, sizeof(TelemetrySegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        perror("mmap");
+        close(fd);
+        return NULL;
+    }
+
+    TelemetrySegment *segment = (TelemetrySegment *)addr;
+    atomic_store_explicit(&segment->sequence, 1, memory_order_relaxed); // Odd: not readable yet
+    atomic_thread_fence(memory_order_release);
+    memset(&segment->snapshot, 0, sizeof(segment->snapshot));
+    segment->magic = TELEMETRY_MAGIC;
+    segment->version = TELEMETRY_VERSION;
+    segment->writer_pid = (int32_t)getpid();
+    atomic_store_explicit(&segment->sequence, 2, memory_order_release);
+    // The mapping keeps the open file alive, so closing alone would not
+    // drop the lock
+    flock(fd, LOCK_UN);
+    close(fd);
+    return segment;
+}
+
+// Single writer only: callers serialise publishes themselves
+void telemetry_publish(TelemetrySegment *segment, const TelemetrySnapshot *snapshot)
+{
+    if (!segment)
+        return;
+
+    unsigned seq = atomic_load_explicit(&segment->sequence, memory_order_relaxed);
+    atomic_store_explicit(&segment->sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release); // Odd sequence is visible before any payload store
+    segment->snapshot = *snapshot;
+    atomic_store_explicit(&segment->sequence, seq + 2, memory_order_release);
+}
+
+// Detaches the writer. The name is only unlinked while it still refers to a
+// segment this process writes, never one another simulator has taken over.
+void telemetry_destroy(TelemetrySegment *segment, const char *name)
+{
+    if (!segment)
+        return;
+    bool owned = named_writer(name) == (int32_t)getpid();
+    if (segment->writer_pid == (int32_t)getpid())
+        segment->writer_pid = 0; // Tell attached readers the simulator has gone
+    munmap(segment, sizeof(TelemetrySegment));
+    if (owned)
+        shm_unlink(name);
+}
+
+const TelemetrySegment *telemetry_attach(const char *name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(TelemetrySegment))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void *addr = mmap(NULL, sizeof(TelemetrySegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return NULL;
+
+    const TelemetrySegment *segment = (const TelemetrySegment *)addr;
+    if (segment->magic != TELEMETRY_MAGIC || segment->version != TELEMETRY_VERSION)
+    {
+        fprintf(stderr, "%s is not a version %d telemetry segment\n", name, TELEMETRY_VERSION);
+        munmap(addr, sizeof(TelemetrySegment));
+        return NULL;
+    }
+    return segment;
+}
+
+// Copies a consistent snapshot. Returns false only if the writer stays
+// mid-update for the whole retry budget, which means it died while publishing.
+bool telemetry_read(const TelemetrySegment *segment, TelemetrySnapshot *out)
+{
+    atomic_uint *sequence = (atomic_uint *)&segment->sequence; // Loads only; the mapping is read-only
+
+    for (int attempt = 0; attempt < 1000000; attempt++)
+    {
+        unsigned before = atomic_load_explicit(sequence, memory_order_acquire);
+        if (before & 1)
+            continue; // Writer is mid-update
+
+        *out = segment->snapshot;
+        atomic_thread_fence(memory_order_acquire); // Payload loads complete before the re-check
+        if (atomic_load_explicit(sequence, memory_order_relaxed) == before)
+            return true;
+    }
+    return false;
+}
+
+void telemetry_detach(const TelemetrySegment *segment)
+{
+    if (segment)
+        munmap((void *)segment, sizeof(TelemetrySegment));
+}
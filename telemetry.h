@@ -0,0 +1,53 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "scheduler.h"
+
+#define TELEMETRY_NAME "/traffic_junction" // POSIX shm name, visible as /dev/shm/traffic_junction
+#define TELEMETRY_MAGIC 0x4E4A5454u        // "TTJN"
+#define TELEMETRY_VERSION 2
+
+// Everything a monitor sees, copied out as one consistent snapshot
+typedef struct
+{
+    uint64_t updates; // Number of publishes so far
+    double sim_time;  // Simulator clock at the last publish (s)
+    int32_t current_light;
+    int32_t high_priority_mode;
+    int32_t emergency_override;
+    int32_t lane_count[NUM_LANES];
+    uint64_t lane_served[NUM_LANES];
+    uint64_t total_arrived;
+    uint64_t total_served;
+    uint32_t emergency_lanes;    // Bit i set while lane i+1 holds an emergency vehicle
+    int32_t preempted_lane;      // Lane green for an emergency vehicle, 0 if none
+    uint64_t emergency_greens;   // Emergency arrivals that have been given the green
+    double emergency_latency_avg; // Arrival to green (s)
+    double emergency_latency_max;
+} TelemetrySnapshot;
+
+// Shared-memory layout. One writer (the simulator, under its own mutex) bumps
+// `sequence` to odd, writes the snapshot, then bumps it to even. Readers copy
+// the snapshot and retry if the sequence was odd or moved, so they never take
+// a lock or make a syscall and cannot slow the writer down.
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t writer_pid;
+    _Alignas(64) atomic_uint sequence;
+    _Alignas(64) TelemetrySnapshot snapshot;
+} TelemetrySegment;
+
+TelemetrySegment *telemetry_create(const char *name);
+void telemetry_publish(TelemetrySegment *segment, const TelemetrySnapshot *snapshot);
+void telemetry_destroy(TelemetrySegment *segment, const char *name);
+
+const TelemetrySegment *telemetry_attach(const char *name);
+bool telemetry_read(const TelemetrySegment *segment, TelemetrySnapshot *out);
+void telemetry_detach(const TelemetrySegment *segment);
+
+#endif
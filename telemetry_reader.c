@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include "telemetry.h"
+
+static const char *laneName(int i, char *buf)
+{
+    sprintf(buf, "%cL%d", 'A' + i / 3, i % 3 + 1);
+    return buf;
+}
+
+static bool writerAlive(const TelemetrySegment *segment)
+{
+    pid_t pid = segment->writer_pid;
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+static void printSnapshot(const TelemetrySnapshot *s, bool alive, bool clear)
+{
+    char name[8];
+    if (clear)
+        printf("\033[H\033[2J");
+
+    printf("═══════════════════════════════════════════════\n");
+    printf("🚦 TRAFFIC JUNCTION TELEMETRY%s\n", alive ? "" : " (simulator stopped)");
+    printf("═══════════════════════════════════════════════\n");
+    printf("t=%.1fs  updates=%llu  arrived=%llu  served=%llu\n",
+           s->sim_time, (unsigned long long)s->updates,
+           (unsigned long long)s->total_arrived, (unsigned long long)s->total_served);
+    printf("Light: %s  Mode: %s%s\n",
+           s->current_light > 0 ? laneName(s->current_light - 1, name) : "all red",
+           s->high_priority_mode ? "🔴 HIGH" : "🟢 NORMAL",
+           s->emergency_override ? "  🚨 EMERGENCY" : "");
+    printf("Preemption: %s  greens=%llu  latency avg=%.2fs max=%.2fs\n",
+           s->preempted_lane > 0 ? laneName(s->preempted_lane - 1, name) : "none",
+           (unsigned long long)s->emergency_greens, s->emergency_latency_avg, s->emergency_latency_max);
+    printf("───────────────────────────────────────────────\n");
+    printf("Lane   Waiting     Served\n");
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        printf("%-4s %s %7d %10llu%s\n", laneName(i, name),
+               s->current_light == i + 1 ? "🟢" : "  ",
+               s->lane_count[i], (unsigned long long)s->lane_served[i],
+               s->emergency_lanes & (1u << i) ? "  🚑" : "");
+    }
+    fflush(stdout);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -n NAME   Shared-memory segment (default %s)\n"
+            "  -i MS     Poll interval in milliseconds (default 250)\n"
+            "  -1        Print one snapshot and exit\n",
+            prog, TELEMETRY_NAME);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *name = TELEMETRY_NAME;
+    int intervalMs = 250;
+    bool once = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:i:1h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': name = optarg; break;
+        case 'i': intervalMs = atoi(optarg); break;
+        case '1': once = true; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (intervalMs < 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const TelemetrySegment *segment = telemetry_attach(name);
+    if (!segment && once)
+    {
+        fprintf(stderr, "No telemetry at %s; is the simulator running?\n", name);
+        return 1;
+    }
+    if (!segment)
+        fprintf(stderr, "⏳ Waiting for the simulator to publish %s...\n", name);
+    while (!segment)
+    {
+        usleep(500000);
+        segment = telemetry_attach(name);
+    }
+
+    uint64_t lastUpdates = UINT64_MAX;
+    while (1)
+    {
+        TelemetrySnapshot snapshot;
+        if (!telemetry_read(segment, &snapshot))
+        {
+            fprintf(stderr, "Telemetry writer stalled mid-update\n");
+            telemetry_detach(segment);
+            return 1;
+        }
+
+        bool alive = writerAlive(segment);
+        if (snapshot.updates != lastUpdates || once)
+        {
+            printSnapshot(&snapshot, alive, !once);
+            lastUpdates = snapshot.updates;
+        }
+        if (once)
+            break;
+        if (!alive)
+        {
+            printf("Simulator exited.\n");
+            break;
+        }
+        usleep(intervalMs * 1000);
+    }
+
+    telemetry_detach(segment);
+    return 0;
+}
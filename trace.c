@@ -0,0 +1,255 @@
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#define MAX_TRACED_THREADS 64
+
+typedef struct
+{
+    atomic_uint_fast64_t seq; // index + 1 once the slot is complete, 0 while it is being written
+    const char *name;         // Static strings only
+    char detail[TRACE_DETAIL_SIZE]; // Copied, so callers may free theirs; "" for none
+    uint64_t start;
+    uint64_t end;
+} TraceEvent;
+
+// Written only by its owning thread; the dumper reads it concurrently and
+// uses each slot's seq to skip events overwritten mid-copy
+typedef struct
+{
+    char name[32];
+    long tid;
+    atomic_uint_fast64_t written;
+    TraceEvent events[TRACE_EVENTS_PER_THREAD];
+} TraceBuffer;
+
+atomic_bool traceEnabled = false;
+
+static char tracePath[256];
+static TraceBuffer *buffers[MAX_TRACED_THREADS];
+static atomic_int numBuffers = 0;
+static pthread_mutex_t registerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t dumpLock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local TraceBuffer *threadBuffer = NULL;
+static int dumpPipe[2] = {-1, -1};
+
+uint64_t trace_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Enables tracing; dumps go to `path`. Call before starting traced threads.
+bool trace_init(const char *path)
+{
+    if (strlen(path) >= sizeof(tracePath))
+    {
+        fprintf(stderr, "Trace path too long: %s\n", path);
+        return false;
+    }
+    strcpy(tracePath, path);
+    atomic_store(&traceEnabled, true);
+    return true;
+}
+
+static TraceBuffer *registerThread(const char *name)
+{
+    pthread_mutex_lock(&registerLock);
+    int n = atomic_load(&numBuffers);
+    TraceBuffer *buffer = NULL;
+    if (n < MAX_TRACED_THREADS)
+        buffer = calloc(1, sizeof(TraceBuffer));
+    if (buffer)
+    {
+        snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+        buffer->tid = (long)syscall(SYS_gettid);
+        buffers[n] = buffer;
+        atomic_store_explicit(&numBuffers, n + 1, memory_order_release);
+    }
+    pthread_mutex_unlock(&registerLock);
+
+    if (!buffer)
+        fprintf(stderr, "Trace buffer unavailable for thread %s\n", name);
+    return buffer;
+}
+
+// Names the calling thread in the trace, registering its buffer if needed
+void trace_thread_name(const char *name)
+{
+    if (!atomic_load_explicit(&traceEnabled, memory_order_relaxed))
+        return;
+    if (threadBuffer)
+        snprintf(threadBuffer->name, sizeof(threadBuffer->name), "%s", name);
+    else
+        threadBuffer = registerThread(name);
+}
+
+// Records a completed span on the calling thread. `detail` (may be NULL) is
+// shown as the span's argument; it is copied, truncated to TRACE_DETAIL_SIZE.
+void trace_span(const char *name, const char *detail, uint64_t start, uint64_t end)
+{
+    if (!atomic_load_explicit(&traceEnabled, memory_order_relaxed))
+        return;
+    if (!threadBuffer)
+    {
+        char fallback[32];
+        snprintf(fallback, sizeof(fallback), "thread %ld", (long)syscall(SYS_gettid));
+        threadBuffer = registerThread(fallback);
+        if (!threadBuffer)
+            return;
+    }
+
+    uint64_t index = atomic_load_explicit(&threadBuffer->written, memory_order_relaxed);
+    TraceEvent *event = &threadBuffer->events[index % TRACE_EVENTS_PER_THREAD];
+    atomic_store_explicit(&event->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    event->name = name;
+    if (detail)
+    {
+        strncpy(event->detail, detail, TRACE_DETAIL_SIZE - 1);
+        event->detail[TRACE_DETAIL_SIZE - 1] = '\0';
+    }
+    else
+    {
+        event->detail[0] = '\0';
+    }
+    event->start = start;
+    event->end = end;
+    atomic_store_explicit(&event->seq, index + 1, memory_order_release);
+    atomic_store_explicit(&threadBuffer->written, index + 1, memory_order_release);
+}
+
+static void writeJsonString(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s; s++)
+    {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', out);
+        if ((unsigned char)*s >= 0x20)
+            fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+// Writes every buffered span to the trace path, replacing the previous dump.
+// Returns the number of spans written, or -1 on error.
+long trace_dump(void)
+{
+    if (!atomic_load(&traceEnabled))
+        return -1;
+
+    pthread_mutex_lock(&dumpLock);
+    char tmpPath[sizeof(tracePath) + 8];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", tracePath);
+    FILE *out = fopen(tmpPath, "w");
+    if (!out)
+    {
+        perror(tmpPath);
+        pthread_mutex_unlock(&dumpLock);
+        return -1;
+    }
+
+    long count = 0;
+    int pid = (int)getpid();
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"traffic junction\"}}", pid);
+
+    int n = atomic_load_explicit(&numBuffers, memory_order_acquire);
+    for (int b = 0; b < n; b++)
+    {
+        TraceBuffer *buffer = buffers[b];
+        fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%ld,\"args\":{\"name\":", pid, buffer->tid);
+        writeJsonString(out, buffer->name);
+        fprintf(out, "}}");
+
+        uint64_t written = atomic_load_explicit(&buffer->written, memory_order_acquire);
+        uint64_t first = written > TRACE_EVENTS_PER_THREAD ? written - TRACE_EVENTS_PER_THREAD : 0;
+        for (uint64_t i = first; i < written; i++)
+        {
+            TraceEvent *slot = &buffer->events[i % TRACE_EVENTS_PER_THREAD];
+            uint64_t before = atomic_load_explicit(&slot->seq, memory_order_acquire);
+            TraceEvent copy;
+            copy.name = slot->name;
+            memcpy(copy.detail, slot->detail, TRACE_DETAIL_SIZE);
+            copy.start = slot->start;
+            copy.end = slot->end;
+            atomic_thread_fence(memory_order_acquire);
+            if (before != i + 1 || atomic_load_explicit(&slot->seq, memory_order_relaxed) != before)
+                continue; // Overwritten while we were reading it
+
+            fprintf(out, ",\n{\"name\":");
+            writeJsonString(out, copy.name);
+            fprintf(out, ",\"ph\":\"X\",\"pid\":%d,\"tid\":%ld,\"ts\":%.3f,\"dur\":%.3f",
+                    pid, buffer->tid, copy.start / 1000.0, (copy.end - copy.start) / 1000.0);
+            if (copy.detail[0])
+            {
+                fprintf(out, ",\"args\":{\"detail\":");
+                writeJsonString(out, copy.detail);
+                fputc('}', out);
+            }
+            fputc('}', out);
+            count++;
+        }
+    }
+    fprintf(out, "\n]}\n");
+
+    bool ok = fclose(out) == 0 && rename(tmpPath, tracePath) == 0;
+    pthread_mutex_unlock(&dumpLock);
+    if (!ok)
+    {
+        perror(tracePath);
+        return -1;
+    }
+    printf("🧵 Wrote %ld trace spans to %s\n", count, tracePath);
+    return count;
+}
+
+static void onDumpSignal(int signo)
+{
+    (void)signo;
+    char byte = 1;
+    ssize_t ignored = write(dumpPipe[1], &byte, 1); // write() is async-signal-safe; dumping is not
+    (void)ignored;
+}
+
+static void *dumpThread(void *arg)
+{
+    (void)arg;
+    char byte;
+    while (read(dumpPipe[0], &byte, 1) > 0)
+        trace_dump();
+    return NULL;
+}
+
+// Dumps the trace whenever the process receives `signo` (e.g. SIGUSR1)
+bool trace_install_dump_signal(int signo)
+{
+    if (pipe(dumpPipe) != 0)
+    {
+        perror("pipe");
+        return false;
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, dumpThread, NULL) != 0)
+    {
+        fprintf(stderr, "Failed to start trace dump thread\n");
+        return false;
+    }
+    pthread_detach(thread);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onDumpSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    return sigaction(signo, &action, NULL) == 0;
+}
@@ -0,0 +1,25 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define TRACE_EVENTS_PER_THREAD 65536 // Ring size; the oldest spans are overwritten
+#define TRACE_DETAIL_SIZE 48          // Longer span details are truncated
+
+// Span tracing into per-thread ring buffers, dumped as Chrome trace-event
+// JSON (load in chrome://tracing or ui.perfetto.dev). While tracing is off,
+// TRACE_NOW() and trace_span() reduce to one relaxed load and a branch.
+extern atomic_bool traceEnabled;
+
+#define TRACE_NOW() (atomic_load_explicit(&traceEnabled, memory_order_relaxed) ? trace_now() : 0)
+
+bool trace_init(const char *path);
+void trace_thread_name(const char *name);
+uint64_t trace_now(void);
+void trace_span(const char *name, const char *detail, uint64_t start, uint64_t end);
+bool trace_install_dump_signal(int signo);
+long trace_dump(void);
+
+#endif
@@ -1,11 +1,74 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <time.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <signal.h>
+#include <sys/file.h>
+#include "credits.h"
 
-#define FILENAME "vehicles.data"
+#define DEFAULT_INTERVAL_MS 1500
+#define DEFAULT_LANE_BUFFER 32 // Vehicles held per lane while it has no credit
+#define MAX_LANE_BUFFER 4096
+#define POLL_MS 100     // Credit re-check period while blocked
+#define STATS_EVERY 20  // Print stats every N generated vehicles
+#define DEFAULT_BUS_PERCENT 5
+#define DEFAULT_EMERGENCY_PERCENT 1
+
+typedef enum
+{
+    POLICY_BLOCK,       // Stop generating until the lane has room
+    POLICY_SHED_OLDEST, // Discard the longest-waiting buffered vehicle
+    POLICY_SHED_NEWEST  // Discard the vehicle just generated
+} OverloadPolicy;
+
+typedef struct
+{
+    char id[9];
+    char road;
+    int lane;
+    char vehicleClass; // One of VEHICLE_CLASS_CODES
+    unsigned long long timestamp; // Wall clock ms at generation; the simulator merges shards by it
+} PendingVehicle;
+
+// Bounded FIFO of vehicles generated for one lane but not yet sent
+typedef struct
+{
+    PendingVehicle *items;
+    int head;
+    int count;
+    unsigned long sent; // Cumulative vehicles written for this lane in the current session
+} LaneBuffer;
+
+typedef struct
+{
+    bool valid;
+    char session[32];
+    unsigned long accepted[NUM_LANES];
+    int freeSlots[NUM_LANES];
+} Credits;
+
+typedef struct
+{
+    unsigned long generated;
+    unsigned long sent;
+    unsigned long shedOldest;
+    unsigned long shedNewest;
+    unsigned long blockedEvents;
+    double blockedSeconds;
+} GeneratorStats;
+
+static volatile sig_atomic_t stopRequested = 0;
+static char vehiclePath[64]; // This producer's shard of the simulator's input
+static char creditsPath[64];
+
+static void handleStop(int sig)
+{
+    (void)sig;
+    stopRequested = 1;
+}
 
 void generateVehicleNumber(char *buffer)
 {
@@ -20,31 +83,284 @@ void generateVehicleNumber(char *buffer)
     buffer[8] = '\0';
 }
 
-int main()
+static unsigned long long nowMs(void)
 {
-    srand(time(NULL));
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
-    while (1)
+static const char *policyName(OverloadPolicy policy)
+{
+    switch (policy)
     {
-        FILE *file = fopen(FILENAME, "a");
+    case POLICY_SHED_OLDEST: return "shed-oldest";
+    case POLICY_SHED_NEWEST: return "shed-newest";
+    default: return "block";
+    }
+}
+
+// Reads the simulator's latest advertisement. A new session means the
+// simulator restarted, so per-lane send counts are rebased onto its counts.
+void refreshCredits(Credits *credits, LaneBuffer lanes[NUM_LANES])
+{
+    FILE *file = fopen(creditsPath, "r");
+    if (!file)
+        return; // Keep the last advertisement (or none) until the simulator writes one
+
+    Credits next;
+    char tag[16];
+    bool ok = fscanf(file, "%15s %31s", tag, next.session) == 2 && strcmp(tag, CREDITS_TAG) == 0;
+    for (int i = 0; ok && i < NUM_LANES; i++)
+        ok = fscanf(file, "%lu", &next.accepted[i]) == 1;
+    for (int i = 0; ok && i < NUM_LANES; i++)
+        ok = fscanf(file, "%d", &next.freeSlots[i]) == 1;
+    fclose(file);
+
+    if (!ok)
+    {
+        fprintf(stderr, "Ignoring malformed %s\n", creditsPath);
+        return;
+    }
+
+    if (!credits->valid || strcmp(credits->session, next.session) != 0)
+    {
+        printf("🔗 Simulator session %s: %s\n", next.session, credits->valid ? "restarted, resyncing credits" : "credits received");
+        for (int i = 0; i < NUM_LANES; i++)
+            lanes[i].sent = next.accepted[i];
+    }
+    next.valid = true;
+    *credits = next;
+}
+
+// Free capacity in the lane minus vehicles already sent but not yet read
+int availableCredit(const Credits *credits, const LaneBuffer *lane, int index)
+{
+    if (!credits->valid)
+        return 0;
+    long inFlight = (long)lane->sent - (long)credits->accepted[index];
+    long available = credits->freeSlots[index] - (inFlight > 0 ? inFlight : 0);
+    return available > 0 ? (int)available : 0;
+}
+
+// Sends buffered vehicles, oldest first, as far as each lane's credit allows
+void flushLanes(LaneBuffer lanes[NUM_LANES], int bufferSize, const Credits *credits, GeneratorStats *stats)
+{
+    FILE *file = NULL;
+
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        int n = availableCredit(credits, &lanes[i], i);
+        if (n > lanes[i].count)
+            n = lanes[i].count;
+        if (n == 0)
+            continue;
+
         if (!file)
         {
-            fprintf(stderr, "Error opening vehicles.data: %s\n", strerror(errno));
-            usleep(2000000);
-            continue;
+            file = fopen(vehiclePath, "a");
+            if (!file)
+            {
+                fprintf(stderr, "Error opening %s: %s\n", vehiclePath, strerror(errno));
+                return; // Vehicles stay buffered for the next attempt
+            }
+            flock(fileno(file), LOCK_EX); // The simulator truncates under this lock
         }
 
-        char vehicle[9];
-        generateVehicleNumber(vehicle);
-        char road = "ABCD"[rand() % 4];
-        int lane = (rand() % 3) + 1;
+        for (int k = 0; k < n; k++)
+        {
+            PendingVehicle *v = &lanes[i].items[lanes[i].head];
+            fprintf(file, "%s:%c:%d:%llu:%c\n", v->id, v->road, v->lane, v->timestamp, v->vehicleClass);
+            lanes[i].head = (lanes[i].head + 1) % bufferSize;
+            lanes[i].count--;
+            lanes[i].sent++;
+            stats->sent++;
+        }
+    }
 
-        fprintf(file, "%s:%c:%d\n", vehicle, road, lane);
+    if (file)
+    {
         fflush(file);
+        flock(fileno(file), LOCK_UN);
         fclose(file);
-        printf("Generated: %s:%c:%d\n", vehicle, road, lane);
-        usleep(1500000);
+    }
+}
+
+void printStats(const GeneratorStats *stats, LaneBuffer lanes[NUM_LANES])
+{
+    int buffered = 0;
+    for (int i = 0; i < NUM_LANES; i++)
+        buffered += lanes[i].count;
+
+    printf("📊 generated=%lu sent=%lu buffered=%d shed_oldest=%lu shed_newest=%lu blocked=%lu (%.1fs)\n",
+           stats->generated, stats->sent, buffered, stats->shedOldest, stats->shedNewest,
+           stats->blockedEvents, stats->blockedSeconds);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -p POLICY  Overload policy when a lane's buffer is full: block, shed-oldest, shed-newest (default block)\n"
+            "  -b N       Vehicles buffered per lane while it has no credit (default %d)\n"
+            "  -i MS      Milliseconds between vehicles (default %d)\n"
+            "  -s SHARD   Input shard to feed, matching the simulator's --shards (default 0)\n"
+            "  -B PCT     Percentage of vehicles that are buses (default %d)\n"
+            "  -E PCT     Percentage of vehicles that are emergency vehicles (default %d)\n",
+            prog, DEFAULT_LANE_BUFFER, DEFAULT_INTERVAL_MS, DEFAULT_BUS_PERCENT, DEFAULT_EMERGENCY_PERCENT);
+}
+
+int main(int argc, char *argv[])
+{
+    OverloadPolicy policy = POLICY_BLOCK;
+    int bufferSize = DEFAULT_LANE_BUFFER;
+    int intervalMs = DEFAULT_INTERVAL_MS;
+    int shard = 0;
+    int busPercent = DEFAULT_BUS_PERCENT;
+    int emergencyPercent = DEFAULT_EMERGENCY_PERCENT;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:b:i:s:B:E:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            if (strcmp(optarg, "block") == 0)
+                policy = POLICY_BLOCK;
+            else if (strcmp(optarg, "shed-oldest") == 0)
+                policy = POLICY_SHED_OLDEST;
+            else if (strcmp(optarg, "shed-newest") == 0)
+                policy = POLICY_SHED_NEWEST;
+            else
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'b': bufferSize = atoi(optarg); break;
+        case 'i': intervalMs = atoi(optarg); break;
+        case 's': shard = atoi(optarg); break;
+        case 'B': busPercent = atoi(optarg); break;
+        case 'E': emergencyPercent = atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (bufferSize < 1 || bufferSize > MAX_LANE_BUFFER || intervalMs < 1 || shard < 0 || shard >= MAX_SHARDS ||
+        busPercent < 0 || emergencyPercent < 0 || busPercent + emergencyPercent > 100)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    shard_file_name(vehiclePath, sizeof(vehiclePath), VEHICLE_BASE_FILE, shard);
+    shard_file_name(creditsPath, sizeof(creditsPath), CREDITS_BASE_FILE, shard);
+
+    LaneBuffer lanes[NUM_LANES];
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        lanes[i] = (LaneBuffer){malloc(sizeof(PendingVehicle) * bufferSize), 0, 0, 0};
+        if (!lanes[i].items)
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
     }
 
+    Credits credits = {0};
+    GeneratorStats stats = {0};
+    signal(SIGINT, handleStop);
+    signal(SIGTERM, handleStop);
+    srand(time(NULL) ^ (shard * 7919));
+
+    printf("🚗 Generating a vehicle every %dms into %s, overload policy %s, %d buffered per lane\n",
+           intervalMs, vehiclePath, policyName(policy), bufferSize);
+
+    while (!stopRequested)
+    {
+        PendingVehicle v;
+        generateVehicleNumber(v.id);
+        v.timestamp = nowMs();
+        v.road = "ABCD"[rand() % 4];
+        v.lane = (rand() % 3) + 1;
+        int roll = rand() % 100;
+        v.vehicleClass = roll < emergencyPercent ? 'E' : roll < emergencyPercent + busPercent ? 'B' : 'N';
+        int index = (v.road - 'A') * 3 + v.lane - 1;
+        LaneBuffer *lane = &lanes[index];
+        stats.generated++;
+
+        refreshCredits(&credits, lanes);
+        flushLanes(lanes, bufferSize, &credits, &stats);
+
+        bool shed = false;
+        if (lane->count == bufferSize)
+        {
+            switch (policy)
+            {
+            case POLICY_BLOCK:
+            {
+                // Stall the arrival process until the simulator frees space
+                printf("⏸️  %cL%d has no credit and a full buffer, blocking\n", v.road, v.lane);
+                stats.blockedEvents++;
+                time_t start = time(NULL);
+                while (lane->count == bufferSize && !stopRequested)
+                {
+                    usleep(POLL_MS * 1000);
+                    refreshCredits(&credits, lanes);
+                    flushLanes(lanes, bufferSize, &credits, &stats);
+                }
+                stats.blockedSeconds += difftime(time(NULL), start);
+                break;
+            }
+            case POLICY_SHED_OLDEST:
+            {
+                PendingVehicle *oldest = &lane->items[lane->head];
+                printf("🗑️  Shed oldest %s from %cL%d (buffer full)\n", oldest->id, oldest->road, oldest->lane);
+                lane->head = (lane->head + 1) % bufferSize;
+                lane->count--;
+                stats.shedOldest++;
+                break;
+            }
+            case POLICY_SHED_NEWEST:
+                printf("🗑️  Shed newest %s for %cL%d (buffer full)\n", v.id, v.road, v.lane);
+                stats.shedNewest++;
+                shed = true;
+                break;
+            }
+        }
+
+        if (!shed && lane->count < bufferSize)
+        {
+            lane->items[(lane->head + lane->count) % bufferSize] = v;
+            lane->count++;
+            flushLanes(lanes, bufferSize, &credits, &stats);
+
+            if (lane->count > 0)
+                printf("Generated: %s:%c:%d:%c (buffered, %d waiting for credit)\n", v.id, v.road, v.lane, v.vehicleClass, lane->count);
+            else
+                printf("Generated: %s:%c:%d:%c\n", v.id, v.road, v.lane, v.vehicleClass);
+        }
+        else if (!shed)
+        {
+            printf("Unsent at exit: %s:%c:%d\n", v.id, v.road, v.lane); // Stopped while blocked
+        }
+
+        if (stats.generated % STATS_EVERY == 0)
+            printStats(&stats, lanes);
+        usleep(intervalMs * 1000);
+    }
+
+    // Anything still buffered was never sent; report it rather than lose it quietly
+    printStats(&stats, lanes);
+    for (int i = 0; i < NUM_LANES; i++)
+    {
+        for (int k = 0; k < lanes[i].count; k++)
+        {
+            PendingVehicle *v = &lanes[i].items[(lanes[i].head + k) % bufferSize];
+            printf("Unsent at exit: %s:%c:%d\n", v->id, v->road, v->lane);
+        }
+        free(lanes[i].items);
+    }
     return 0;
-}
\ No newline at end of file
+}